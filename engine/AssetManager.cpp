@@ -0,0 +1,238 @@
+#include <algorithm>
+#include "AssetManager.hpp"
+#include "TextureManager.hpp"
+#include "AudioManager.hpp"
+
+std::unordered_map<std::string, AssetManager::TextureHandle> AssetManager::textures;
+std::unordered_map<std::string, AssetManager::FontHandle> AssetManager::fonts;
+std::unordered_map<std::string, AssetManager::SoundHandle> AssetManager::sounds;
+std::unordered_map<std::string, AssetManager::MusicHandle> AssetManager::musics;
+std::vector<std::shared_ptr<void>> AssetManager::kept;
+
+std::thread AssetManager::preload_thread;
+std::mutex AssetManager::preload_mutex;
+std::condition_variable AssetManager::preload_cv;
+bool AssetManager::preload_stopping = false;
+std::vector<std::string> AssetManager::pending_surfaces;
+std::vector<std::string> AssetManager::pending_sounds;
+std::unordered_map<std::string, SDL_Surface*> AssetManager::decoded_surfaces;
+std::unordered_map<std::string, Mix_Chunk*> AssetManager::decoded_sounds;
+std::vector<std::string> AssetManager::preload_wanted;
+
+static bool contains(const std::vector<std::string>& v, const std::string& s) {
+    return std::find(v.begin(), v.end(), s) != v.end();
+}
+
+AssetManager::TextureHandle AssetManager::texture(const std::string& path) {
+    auto it = AssetManager::textures.find(path);
+    if(it != AssetManager::textures.end()) { return it->second; }
+
+    SDL_Texture* tex = nullptr;
+    SDL_Surface* surface = takeDecodedSurface(path);
+    if(surface) {
+        tex = SDL_CreateTextureFromSurface(Game::renderer, surface);
+        SDL_FreeSurface(surface);
+        if(tex == NULL) { SDL_Log("Unable to create texture from %s. SDL Error: %s\n", path.c_str(), SDL_GetError()); }
+    } else {
+        tex = TextureManager::LoadTexture(path.c_str());
+    }
+    if(tex == nullptr) { return nullptr; } // not cached, so it's tried again next time
+    TextureHandle handle(tex, SDL_DestroyTexture);
+    AssetManager::textures.emplace(path, handle);
+    return handle;
+}
+
+AssetManager::FontHandle AssetManager::font(const std::string& path, int size) {
+    const std::string key = path+'#'+std::to_string(size);
+    auto it = AssetManager::fonts.find(key);
+    if(it != AssetManager::fonts.end()) { return it->second; }
+
+    TTF_Font* f = TTF_OpenFont(path.c_str(), size);
+    if(f == nullptr) {
+        SDL_Log("Unable to open font %s. SDL_ttf Error: %s\n", path.c_str(), SDL_GetError());
+        return nullptr;
+    }
+    FontHandle handle(f, TTF_CloseFont);
+    AssetManager::fonts.emplace(key, handle);
+    return handle;
+}
+
+AssetManager::SoundHandle AssetManager::sound(const std::string& path) {
+    auto it = AssetManager::sounds.find(path);
+    if(it != AssetManager::sounds.end()) { return it->second; }
+
+    Mix_Chunk* chunk = takeDecodedSound(path);
+    if(chunk == nullptr) { chunk = AudioManager::LoadSound(path.c_str()); }
+    if(chunk == nullptr) { return nullptr; }
+    SoundHandle handle(chunk, Mix_FreeChunk);
+    AssetManager::sounds.emplace(path, handle);
+    return handle;
+}
+
+AssetManager::MusicHandle AssetManager::music(const std::string& path) {
+    auto it = AssetManager::musics.find(path);
+    if(it != AssetManager::musics.end()) { return it->second; }
+
+    Mix_Music* m = AudioManager::LoadMusic(path.c_str());
+    if(m == nullptr) { return nullptr; }
+    MusicHandle handle(m, Mix_FreeMusic);
+    AssetManager::musics.emplace(path, handle);
+    return handle;
+}
+
+std::vector<std::shared_ptr<void>> AssetManager::acquire(const SceneManifest& manifest) {
+    std::vector<std::shared_ptr<void>> handles;
+    handles.reserve(manifest.textures.size() + manifest.sounds.size() + manifest.music.size());
+    for(const std::string& path : manifest.textures) { handles.push_back(texture(path)); }
+    for(const std::string& path : manifest.sounds)   { handles.push_back(sound(path)); }
+    for(const std::string& path : manifest.music)    { handles.push_back(music(path)); }
+    return handles;
+}
+
+void AssetManager::preload(const std::vector<const SceneManifest*>& manifests) {
+    {
+        std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+        AssetManager::preload_wanted.clear();
+        AssetManager::pending_surfaces.clear();
+        AssetManager::pending_sounds.clear();
+        for(const SceneManifest* manifest : manifests) {
+            for(const std::string& path : manifest->textures) {
+                if(!contains(AssetManager::preload_wanted, path)) { AssetManager::preload_wanted.push_back(path); }
+                if(AssetManager::textures.count(path) == 0 && AssetManager::decoded_surfaces.count(path) == 0 && !contains(AssetManager::pending_surfaces, path)) {
+                    AssetManager::pending_surfaces.push_back(path);
+                }
+            }
+            for(const std::string& path : manifest->sounds) {
+                if(!contains(AssetManager::preload_wanted, path)) { AssetManager::preload_wanted.push_back(path); }
+                if(AssetManager::sounds.count(path) == 0 && AssetManager::decoded_sounds.count(path) == 0 && !contains(AssetManager::pending_sounds, path)) {
+                    AssetManager::pending_sounds.push_back(path);
+                }
+            }
+        }
+        if(AssetManager::pending_surfaces.empty() && AssetManager::pending_sounds.empty()) { return; }
+        if(!AssetManager::preload_thread.joinable()) {
+            AssetManager::preload_thread = std::thread(AssetManager::preloadWork);
+        }
+    }
+    AssetManager::preload_cv.notify_one();
+}
+
+void AssetManager::preloadWork() {
+    std::string path;
+    while(true) {
+        bool is_surface;
+        {
+            std::unique_lock<std::mutex> lock(AssetManager::preload_mutex);
+            AssetManager::preload_cv.wait(lock, []() {
+                return AssetManager::preload_stopping || !AssetManager::pending_surfaces.empty() || !AssetManager::pending_sounds.empty();
+            });
+            if(AssetManager::preload_stopping) { return; }
+            is_surface = !AssetManager::pending_surfaces.empty();
+            std::vector<std::string>& pending = is_surface ? AssetManager::pending_surfaces : AssetManager::pending_sounds;
+            path = std::move(pending.back());
+            pending.pop_back();
+        }
+
+        if(is_surface) {
+            SDL_Surface* surface = IMG_Load(path.c_str());
+            if(surface == NULL) { SDL_Log("Unable to preload %s. SDL_image Error: %s\n", path.c_str(), IMG_GetError()); }
+            std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+            // the main thread may have loaded it in the meantime, or moved on to another scene
+            if(surface && (!contains(AssetManager::preload_wanted, path) || !AssetManager::decoded_surfaces.emplace(path, surface).second)) {
+                SDL_FreeSurface(surface);
+            }
+        } else {
+            Mix_Chunk* chunk = AudioManager::LoadSound(path.c_str());
+            std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+            if(chunk && (!contains(AssetManager::preload_wanted, path) || !AssetManager::decoded_sounds.emplace(path, chunk).second)) {
+                Mix_FreeChunk(chunk);
+            }
+        }
+    }
+}
+
+SDL_Surface* AssetManager::takeDecodedSurface(const std::string& path) {
+    std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+    // no point in the thread decoding it again
+    AssetManager::pending_surfaces.erase(std::remove(AssetManager::pending_surfaces.begin(), AssetManager::pending_surfaces.end(), path), AssetManager::pending_surfaces.end());
+    auto it = AssetManager::decoded_surfaces.find(path);
+    if(it == AssetManager::decoded_surfaces.end()) { return nullptr; }
+    SDL_Surface* surface = it->second;
+    AssetManager::decoded_surfaces.erase(it);
+    return surface;
+}
+
+Mix_Chunk* AssetManager::takeDecodedSound(const std::string& path) {
+    std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+    AssetManager::pending_sounds.erase(std::remove(AssetManager::pending_sounds.begin(), AssetManager::pending_sounds.end(), path), AssetManager::pending_sounds.end());
+    auto it = AssetManager::decoded_sounds.find(path);
+    if(it == AssetManager::decoded_sounds.end()) { return nullptr; }
+    Mix_Chunk* chunk = it->second;
+    AssetManager::decoded_sounds.erase(it);
+    return chunk;
+}
+
+void AssetManager::keep(std::shared_ptr<void> handle) {
+    if(handle) { AssetManager::kept.push_back(std::move(handle)); }
+}
+
+// erases every entry of `cache` nobody else holds a handle to
+template<typename Cache>
+static void eraseUnused(Cache& cache) {
+    for(auto it = cache.begin(); it != cache.end(); ) {
+        if(it->second.use_count() == 1) {
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AssetManager::releaseUnused() {
+    eraseUnused(AssetManager::textures);
+    eraseUnused(AssetManager::fonts);
+    eraseUnused(AssetManager::sounds);
+    eraseUnused(AssetManager::musics);
+
+    std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+    for(auto it = AssetManager::decoded_surfaces.begin(); it != AssetManager::decoded_surfaces.end(); ) {
+        if(!contains(AssetManager::preload_wanted, it->first) || AssetManager::textures.count(it->first) > 0) {
+            SDL_FreeSurface(it->second);
+            it = AssetManager::decoded_surfaces.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for(auto it = AssetManager::decoded_sounds.begin(); it != AssetManager::decoded_sounds.end(); ) {
+        if(!contains(AssetManager::preload_wanted, it->first) || AssetManager::sounds.count(it->first) > 0) {
+            Mix_FreeChunk(it->second);
+            it = AssetManager::decoded_sounds.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AssetManager::clear() {
+    {
+        std::lock_guard<std::mutex> lock(AssetManager::preload_mutex);
+        AssetManager::preload_stopping = true;
+        AssetManager::pending_surfaces.clear();
+        AssetManager::pending_sounds.clear();
+        AssetManager::preload_wanted.clear();
+    }
+    AssetManager::preload_cv.notify_all();
+    if(AssetManager::preload_thread.joinable()) { AssetManager::preload_thread.join(); }
+    AssetManager::preload_stopping = false;
+
+    for(auto& [path, surface] : AssetManager::decoded_surfaces) { SDL_FreeSurface(surface); }
+    for(auto& [path, chunk] : AssetManager::decoded_sounds) { Mix_FreeChunk(chunk); }
+    AssetManager::decoded_surfaces.clear();
+    AssetManager::decoded_sounds.clear();
+
+    AssetManager::kept.clear();
+    AssetManager::textures.clear();
+    AssetManager::fonts.clear();
+    AssetManager::sounds.clear();
+    AssetManager::musics.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "Game.hpp"
+
+// every asset a scene needs, by path
+struct SceneManifest {
+    std::vector<std::string> textures = {};
+    std::vector<std::string> sounds = {};
+    std::vector<std::string> music = {};
+};
+
+// Single place textures, fonts, sounds and music are loaded from. Each one is loaded once per path (fonts per path and
+// size) and handed out as a shared_ptr: it's freed when the last handle and the cache let it go, so a raw pointer taken
+// from a handle is only good while someone holds the handle.
+// The cache keeps everything alive until releaseUnused(), which frees whatever nobody else holds anymore. Scene calls it
+// after the next scene took its handles, so whatever both scenes use is never reloaded.
+// preload() decodes images and sounds on a background thread. Textures still have to be created on the main thread, so
+// the decoded surfaces wait until texture() asks for them. Fonts and music are only opened on the main thread.
+class AssetManager {
+public:
+    using TextureHandle = std::shared_ptr<SDL_Texture>;
+    using FontHandle    = std::shared_ptr<TTF_Font>;
+    using SoundHandle   = std::shared_ptr<Mix_Chunk>;
+    using MusicHandle   = std::shared_ptr<Mix_Music>;
+
+    static TextureHandle texture(const std::string& path);
+    static FontHandle font(const std::string& path, int size);
+    static SoundHandle sound(const std::string& path);
+    static MusicHandle music(const std::string& path);
+
+    // handles of everything in `manifest`, loading whatever isn't loaded yet. Type erased, they're only there to be held
+    static std::vector<std::shared_ptr<void>> acquire(const SceneManifest& manifest);
+    // starts decoding whatever in `manifests` isn't loaded or decoded yet. Replaces what was asked before
+    static void preload(const std::vector<const SceneManifest*>& manifests);
+    // held until clear(), for things like the default font that outlive every scene
+    static void keep(std::shared_ptr<void> handle);
+    // frees every asset only the cache holds, and every decoded asset that isn't in the last preload()
+    static void releaseUnused();
+    // stops the preloading thread and frees everything. Has to run before SDL and its subsystems quit
+    static void clear();
+
+private:
+    static std::unordered_map<std::string, TextureHandle> textures;
+    static std::unordered_map<std::string, FontHandle> fonts;
+    static std::unordered_map<std::string, SoundHandle> sounds;
+    static std::unordered_map<std::string, MusicHandle> musics;
+    static std::vector<std::shared_ptr<void>> kept;
+
+    // preloading, everything below is behind preload_mutex
+    static std::thread preload_thread;
+    static std::mutex preload_mutex;
+    static std::condition_variable preload_cv;
+    static bool preload_stopping;
+    static std::vector<std::string> pending_surfaces; // still to be decoded
+    static std::vector<std::string> pending_sounds;
+    static std::unordered_map<std::string, SDL_Surface*> decoded_surfaces;
+    static std::unordered_map<std::string, Mix_Chunk*> decoded_sounds;
+    static std::vector<std::string> preload_wanted;
+
+    static void preloadWork();
+    static SDL_Surface* takeDecodedSurface(const std::string& path);
+    static Mix_Chunk* takeDecodedSound(const std::string& path);
+};
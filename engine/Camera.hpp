@@ -46,4 +46,90 @@ Vector2D convertScreenToWorld(
     const Vector2D& focus_point = Game::camera_focus
 ) {
     return panScreenToWorld( deZoom(screen_pos, focus_point) );
-}
\ No newline at end of file
+}
+
+
+/*
+Cached version of the functions above for rendering.
+Pan then zoom boils down to an affine map: screen = world * zoom + offset, where
+offset = -(camera_diff * zoom) - focus * (zoom - 1). So it gets computed once per frame in refresh()
+instead of re-reading the Game:: statics and redoing the (zoom - 1) products for every single point.
+*/
+class Camera {
+public:
+    static float scale;     // camera_zoom when refresh() was called
+    static float inv_scale;
+    static Vector2D offset;
+
+    // call whenever camera_diff, camera_zoom or camera_focus may have changed (at least once per frame before drawing)
+    static void refresh(const Vector2D& focus_point = Game::camera_focus) {
+        Camera::scale = Game::camera_zoom;
+        Camera::inv_scale = 1.0f / Game::camera_zoom;
+        Camera::offset.x = -(Game::camera_diff.x * Game::camera_zoom) - (focus_point.x * (Game::camera_zoom - 1.0f));
+        Camera::offset.y = -(Game::camera_diff.y * Game::camera_zoom) - (focus_point.y * (Game::camera_zoom - 1.0f));
+    }
+
+    static Vector2D worldToScreen(const Vector2D& world_pos) {
+        return Vector2D(world_pos.x * Camera::scale + Camera::offset.x, world_pos.y * Camera::scale + Camera::offset.y);
+    }
+
+    static Vector2D screenToWorld(const Vector2D& screen_pos) {
+        return Vector2D((screen_pos.x - Camera::offset.x) * Camera::inv_scale, (screen_pos.y - Camera::offset.y) * Camera::inv_scale);
+    }
+
+    static SDL_FRect worldToScreen(const SDL_FRect& world_rect) {
+        return {
+            world_rect.x * Camera::scale + Camera::offset.x, world_rect.y * Camera::scale + Camera::offset.y,
+            world_rect.w * Camera::scale,                    world_rect.h * Camera::scale
+        };
+    }
+
+    /*
+    Batched conversions. Vector2D and SDL_FPoint are both two packed floats, so these are straight
+    multiply-add loops over contiguous memory with no branches, which the compiler can vectorise.
+    `shift` is a world translation applied to every point before converting (e.g. render interpolation offsets).
+    */
+    static void worldToScreen(const Vector2D* world, SDL_FPoint* screen, size_t amount, const Vector2D& shift = Vector2D(0.0f, 0.0f)) {
+        const float s = Camera::scale;
+        const float ox = Camera::offset.x + shift.x * s;
+        const float oy = Camera::offset.y + shift.y * s;
+        for(size_t i=0; i<amount; ++i) {
+            screen[i].x = world[i].x * s + ox;
+            screen[i].y = world[i].y * s + oy;
+        }
+    }
+
+    static void worldToScreen(const Vector2D* world, Vector2D* screen, size_t amount) {
+        const float s = Camera::scale;
+        const float ox = Camera::offset.x;
+        const float oy = Camera::offset.y;
+        for(size_t i=0; i<amount; ++i) {
+            screen[i].x = world[i].x * s + ox;
+            screen[i].y = world[i].y * s + oy;
+        }
+    }
+
+    static void screenToWorld(const Vector2D* screen, Vector2D* world, size_t amount) {
+        const float s = Camera::inv_scale;
+        const float ox = Camera::offset.x;
+        const float oy = Camera::offset.y;
+        for(size_t i=0; i<amount; ++i) {
+            world[i].x = (screen[i].x - ox) * s;
+            world[i].y = (screen[i].y - oy) * s;
+        }
+    }
+
+    // the 4 screen corners in world coordinates (clockwise from top left)
+    static void getScreenCornersInWorld(Vector2D* out_corners) {
+        const Vector2D corners[4] = {
+            Vector2D(0.0f, 0.0f), 
+            Vector2D(static_cast<float>(Game::SCREEN_WIDTH), 0.0f),
+            Vector2D(static_cast<float>(Game::SCREEN_WIDTH), static_cast<float>(Game::SCREEN_HEIGHT)),
+            Vector2D(0.0f, static_cast<float>(Game::SCREEN_HEIGHT))
+        };
+        Camera::screenToWorld(corners, out_corners, 4);
+    }
+};
+float Camera::scale = 1.0f;
+float Camera::inv_scale = 1.0f;
+Vector2D Camera::offset = Vector2D(0.0f, 0.0f);
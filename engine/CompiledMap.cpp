@@ -0,0 +1,244 @@
+#include <chrono>
+#include <cstring>
+#include "CompiledMap.hpp"
+#include "Game.hpp"
+
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+static uint64_t alignSection(uint64_t offset) { return (offset + 7) & ~static_cast<uint64_t>(7); }
+
+uint64_t CompiledMap::hashFile(const std::string& path) {
+    MappedFile source;
+    if(!source.open(path)) { return 0; }
+    uint64_t hash = FNV_OFFSET_BASIS;
+    const uint8_t* bytes = source.data();
+    const size_t length = source.size();
+    for(size_t i=0; i<length; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// what a mesh section has to measure for a `width` x `height` map, false if there's none (the macro mesh needs even sizes)
+static bool expectedMeshSize(CompiledMapSection s, uint32_t width, uint32_t height, int64_t& out_width, int64_t& out_height) {
+    int shift = 0;
+    switch(s) {
+        case SECTION_MESH_1:  shift = 0; break;
+        case SECTION_MESH_4:  shift = 1; break;
+        case SECTION_MESH_16: shift = 2; break;
+        case SECTION_MESH_64: shift = 3; break;
+        case SECTION_MESH_MACRO_4: {
+            if(width % 2 != 0 || height % 2 != 0) { return false; }
+            out_width = width >> 1;
+            out_height = height >> 1;
+            return true;
+        }
+        default: return false;
+    }
+    out_width = static_cast<int64_t>(width) << shift;
+    out_height = static_cast<int64_t>(height) << shift;
+    return true;
+}
+
+bool CompiledMap::open(const std::string& map_path) {
+    close();
+    const std::string file_path = map_path+".map";
+    if(!this->file.open(file_path)) { return false; }
+
+    const size_t file_size = this->file.size();
+    if(file_size < sizeof(CompiledMapHeader)) {
+        std::cout << "Compiled map " << file_path << " is too small, ignoring it\n";
+        this->file.close();
+        return false;
+    }
+    const CompiledMapHeader* h = reinterpret_cast<const CompiledMapHeader*>(this->file.data());
+    if(h->magic != COMPILED_MAP_MAGIC || h->version != COMPILED_MAP_VERSION || h->sections_amount != SECTIONS_AMOUNT) {
+        std::cout << "Compiled map " << file_path << " is from another version, recompile it with mapc\n";
+        this->file.close();
+        return false;
+    }
+    const uint64_t pixels_amount = static_cast<uint64_t>(h->width) * h->height;
+    for(uint32_t s=0; s<SECTIONS_AMOUNT; ++s) {
+        const CompiledMapSectionEntry& entry = h->sections[s];
+        // written so nothing can wrap around
+        bool valid = entry.offset % 8 == 0 && entry.offset >= sizeof(CompiledMapHeader) && entry.offset <= file_size && entry.size <= file_size - entry.offset;
+        if(s >= SECTION_MESH_1) {
+            // the meshes are indexed with the map's size, they have to be exactly what it gives for their density
+            int64_t expected_width, expected_height;
+            if(!expectedMeshSize(static_cast<CompiledMapSection>(s), h->width, h->height, expected_width, expected_height)) {
+                valid = valid && entry.width == -1 && entry.height == -1 && entry.size == 0; // a macro mesh the map couldn't be coalesced into
+            } else {
+                valid = valid && entry.width > 0 && entry.height > 0
+                    && entry.width == expected_width && entry.height == expected_height
+                    && entry.size == static_cast<uint64_t>(entry.width) * static_cast<uint64_t>(entry.height);
+            }
+        }
+        if(!valid) {
+            std::cout << "Compiled map " << file_path << " is corrupted (section " << s << "), ignoring it\n";
+            this->file.close();
+            return false;
+        }
+    }
+    if(pixels_amount == 0 || h->sections[SECTION_PIXELS].size != pixels_amount * sizeof(SDL_Color) || h->sections[SECTION_LAYOUT].size != pixels_amount) {
+        std::cout << "Compiled map " << file_path << " is corrupted, ignoring it\n";
+        this->file.close();
+        return false;
+    }
+
+    // without the BMP (e.g. only the compiled maps were shipped) there's nothing it could be stale against.
+    // hashing it is a single read over a few KB, nothing next to building the meshes
+    const uint64_t source_hash = hashFile(map_path+".bmp");
+    if(source_hash != 0 && source_hash != h->source_hash) {
+        std::cout << "Compiled map " << file_path << " is stale, using the BMP instead\n";
+        this->file.close();
+        return false;
+    }
+    this->header = h;
+    return true;
+}
+
+void CompiledMap::close() {
+    this->header = nullptr;
+    this->file.close();
+}
+
+void CompiledMap::copyPixels(MapPixels& out) const {
+    out.resize(this->header->width, this->header->height);
+    memcpy(out.data(), section(SECTION_PIXELS), this->header->sections[SECTION_PIXELS].size);
+}
+
+std::vector<std::pair<int,int>> CompiledMap::spawns() const {
+    const int32_t* table = reinterpret_cast<const int32_t*>(section(SECTION_SPAWNS));
+    const size_t amount = this->header->sections[SECTION_SPAWNS].size / (2*sizeof(int32_t));
+    std::vector<std::pair<int,int>> out;
+    out.reserve(amount);
+    for(size_t i=0; i<amount; ++i) {
+        out.push_back({ table[2*i], table[2*i + 1] });
+    }
+    return out;
+}
+
+bool CompiledMap::matchesLayout(const FlatGrid<uint8_t>& layout) const {
+    return layout.width == this->header->width && layout.height == this->header->height
+        && memcmp(layout.data(), section(SECTION_LAYOUT), layout.cells.size()) == 0;
+}
+
+void CompiledMap::copyMesh(CompiledMapSection s, std::vector<std::vector<uint8_t>>& out_mesh, int& out_width, int& out_height) const {
+    const CompiledMapSectionEntry& entry = this->header->sections[s];
+    out_width = entry.width;
+    out_height = entry.height;
+    out_mesh.clear();
+    if(entry.width <= 0 || entry.height <= 0) { return; }
+    out_mesh.resize(entry.height);
+    const uint8_t* rows = section(s);
+    for(int row=0; row<entry.height; ++row) {
+        out_mesh[row].assign(rows + row*entry.width, rows + (row+1)*entry.width);
+    }
+}
+
+void CompiledMap::copyCollisionMeshes() const {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    copyMesh(SECTION_MESH_1,       Game::collision_mesh_1,       Game::collision_mesh_1_width,       Game::collision_mesh_1_height);
+    copyMesh(SECTION_MESH_4,       Game::collision_mesh_4,       Game::collision_mesh_4_width,       Game::collision_mesh_4_height);
+    copyMesh(SECTION_MESH_16,      Game::collision_mesh_16,      Game::collision_mesh_16_width,      Game::collision_mesh_16_height);
+    copyMesh(SECTION_MESH_64,      Game::collision_mesh_64,      Game::collision_mesh_64_width,      Game::collision_mesh_64_height);
+    copyMesh(SECTION_MESH_MACRO_4, Game::collision_mesh_macro_4, Game::collision_mesh_macro_4_width, Game::collision_mesh_macro_4_height);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Compiled Collision Meshes Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+}
+
+bool CompiledMap::write(
+    const std::string& map_path, uint64_t source_hash,
+    const MapPixels& pixels, const FlatGrid<uint8_t>& layout, const std::vector<std::pair<int,int>>& spawns
+) {
+    CompiledMapHeader h = {};
+    h.magic = COMPILED_MAP_MAGIC;
+    h.version = COMPILED_MAP_VERSION;
+    h.source_hash = source_hash;
+    h.width = pixels.width;
+    h.height = pixels.height;
+    h.sections_amount = SECTIONS_AMOUNT;
+
+    std::vector<int32_t> spawn_table;
+    spawn_table.reserve(spawns.size() * 2);
+    for(const std::pair<int,int>& spawn : spawns) {
+        spawn_table.push_back(spawn.first);
+        spawn_table.push_back(spawn.second);
+    }
+
+    const std::vector<std::vector<uint8_t>>* meshes[] = {
+        &Game::collision_mesh_1, &Game::collision_mesh_4, &Game::collision_mesh_16, &Game::collision_mesh_64, &Game::collision_mesh_macro_4
+    };
+    const int mesh_widths[]  = { Game::collision_mesh_1_width,  Game::collision_mesh_4_width,  Game::collision_mesh_16_width,  Game::collision_mesh_64_width,  Game::collision_mesh_macro_4_width };
+    const int mesh_heights[] = { Game::collision_mesh_1_height, Game::collision_mesh_4_height, Game::collision_mesh_16_height, Game::collision_mesh_64_height, Game::collision_mesh_macro_4_height };
+
+    // sizes first, so the whole file is laid out before anything is written
+    uint64_t offset = alignSection(sizeof(CompiledMapHeader));
+    auto place = [&](CompiledMapSection s, uint64_t size, int32_t w, int32_t h_) {
+        h.sections[s] = { offset, size, w, h_ };
+        offset = alignSection(offset + size);
+    };
+    place(SECTION_PIXELS, pixels.cells.size() * sizeof(SDL_Color), pixels.width, pixels.height);
+    place(SECTION_LAYOUT, layout.cells.size(), layout.width, layout.height);
+    place(SECTION_SPAWNS, spawn_table.size() * sizeof(int32_t), static_cast<int32_t>(spawns.size()), 1);
+    for(int m=0; m<5; ++m) {
+        const uint64_t size = (mesh_widths[m] > 0 && mesh_heights[m] > 0) ? static_cast<uint64_t>(mesh_widths[m]) * mesh_heights[m] : 0;
+        place(static_cast<CompiledMapSection>(SECTION_MESH_1 + m), size, mesh_widths[m], mesh_heights[m]);
+    }
+
+    std::vector<uint8_t> buffer(offset, 0);
+    memcpy(buffer.data(), &h, sizeof(CompiledMapHeader));
+    memcpy(buffer.data() + h.sections[SECTION_PIXELS].offset, pixels.data(), h.sections[SECTION_PIXELS].size);
+    memcpy(buffer.data() + h.sections[SECTION_LAYOUT].offset, layout.data(), h.sections[SECTION_LAYOUT].size);
+    if(!spawn_table.empty()) {
+        memcpy(buffer.data() + h.sections[SECTION_SPAWNS].offset, spawn_table.data(), h.sections[SECTION_SPAWNS].size);
+    }
+    for(int m=0; m<5; ++m) {
+        const CompiledMapSectionEntry& entry = h.sections[SECTION_MESH_1 + m];
+        if(entry.size == 0) { continue; }
+        uint8_t* out = buffer.data() + entry.offset;
+        for(int row=0; row<entry.height; ++row) {
+            memcpy(out + row*entry.width, (*meshes[m])[row].data(), entry.width);
+        }
+    }
+
+    // written next to it and renamed over, so a running game never maps half a file
+    const std::string file_path = map_path+".map";
+    const std::string temp_path = file_path+".tmp";
+    {
+        std::ofstream out(std::filesystem::u8path(temp_path), std::ios::binary | std::ios::trunc);
+        if(!out) {
+            std::cout << "Failed to open " << temp_path << " for writing\n";
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if(!out) {
+            std::cout << "Failed to write " << temp_path << '\n';
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::u8path(temp_path), std::filesystem::u8path(file_path), ec);
+    if(ec) {
+        std::cout << "Failed to replace " << file_path << ": " << ec.message() << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool loadMapPixels(const std::string& map_path, MapPixels& pixels, CompiledMap& compiled) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    bool loaded;
+    if(compiled.open(map_path)) {
+        compiled.copyPixels(pixels);
+        loaded = true;
+    } else {
+        uint32_t width, height;
+        loaded = getBMPPixels(map_path+".bmp", pixels, &width, &height);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Map Pixels (" << (compiled.isOpen() ? "compiled" : "BMP") << ") Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+    return loaded;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include "utils.hpp"
+#include "FlatGrid.hpp"
+
+// Compiled map (assets/maps/<name>.map), built from the BMP by `mapc`. It holds everything a match start used to compute
+// from scratch: the pixels, the tile layout, the spawn table and every collision mesh (the macro mesh is the coarse level
+// the path finding works on). The layout and meshes are the ones of a match where every spawn has a player.
+//
+// [ CompiledMapHeader ][ section ][ section ] ...
+// every section starts on an 8 byte boundary and is read straight out of the mapping, nothing is parsed.
+static constexpr uint32_t COMPILED_MAP_MAGIC   = 0x4d535452; // "RTSM"
+static constexpr uint32_t COMPILED_MAP_VERSION = 1;          // bump whenever the layout of the file or how the meshes are generated changes
+
+enum CompiledMapSection : uint32_t {
+    SECTION_PIXELS = 0,   // SDL_Color per pixel, spawns still COLORS_SPAWN
+    SECTION_LAYOUT,       // tile_type per pixel, spawns as TILE_PLAYER
+    SECTION_SPAWNS,       // int32 {y, x} of every spawn
+    SECTION_MESH_1,
+    SECTION_MESH_4,
+    SECTION_MESH_16,
+    SECTION_MESH_64,
+    SECTION_MESH_MACRO_4, // width/height -1 if the map couldn't be coalesced
+    SECTIONS_AMOUNT
+};
+
+struct CompiledMapSectionEntry {
+    uint64_t offset;
+    uint64_t size;
+    int32_t width;
+    int32_t height;
+};
+
+struct CompiledMapHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash; // FNV-1a of the BMP the file was compiled from
+    uint32_t width;
+    uint32_t height;
+    uint32_t sections_amount;
+    uint32_t padding;
+    CompiledMapSectionEntry sections[SECTIONS_AMOUNT];
+};
+
+class CompiledMap {
+public:
+    CompiledMap() {}
+    CompiledMap(const CompiledMap&) = delete;
+    CompiledMap& operator=(const CompiledMap&) = delete;
+
+    /**
+     * maps `map_path`.map and checks it. Fails if it's missing, from another version or stale (the BMP next to it changed since)
+     * `map_path`: path without the extension, e.g. "assets/maps/map-0"
+     */
+    bool open(const std::string& map_path);
+    void close();
+    bool isOpen() const { return this->header != nullptr; }
+    uint32_t width() const { return this->header->width; }
+    uint32_t height() const { return this->header->height; }
+
+    void copyPixels(MapPixels& out) const;
+    std::vector<std::pair<int,int>> spawns() const;
+    // the meshes are only valid for the layout they were built from, i.e. when the same spawns have players
+    bool matchesLayout(const FlatGrid<uint8_t>& layout) const;
+    // overwrites every Game::collision_mesh_* with the compiled ones
+    void copyCollisionMeshes() const;
+
+    // writes `map_path`.map from the current Game::collision_mesh_*
+    static bool write(
+        const std::string& map_path, uint64_t source_hash,
+        const MapPixels& pixels, const FlatGrid<uint8_t>& layout, const std::vector<std::pair<int,int>>& spawns
+    );
+    // FNV-1a of the whole file, 0 if it can't be read
+    static uint64_t hashFile(const std::string& path);
+
+private:
+    MappedFile file;
+    const CompiledMapHeader* header = nullptr;
+
+    const uint8_t* section(CompiledMapSection s) const { return this->file.data() + this->header->sections[s].offset; }
+    void copyMesh(CompiledMapSection s, std::vector<std::vector<uint8_t>>& out_mesh, int& out_width, int& out_height) const;
+};
+
+// pixels of `map_path` (without extension): out of the compiled map when it's there and up to date, decoding the BMP otherwise.
+// `compiled` is left open when it was used so the match can take the meshes from it too
+bool loadMapPixels(const std::string& map_path, MapPixels& pixels, CompiledMap& compiled);
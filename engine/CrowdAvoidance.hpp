@@ -0,0 +1,261 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "Game.hpp"
+#include "Vector2D.hpp"
+#include "SpatialGrid.hpp"
+#include "ECS/ECS.hpp"
+#include "ECS/DroneComponent.hpp"
+
+// Local avoidance between drones with optimal reciprocal collision avoidance (ORCA, van den Berg et al.), run after the
+// path following picked each drone's preferred velocity and before it's integrated.
+// Every neighbour close enough to hit within TIME_HORIZON cuts the velocities that would make them collide out of a
+// half-plane, and the drone gets the velocity closest to its preferred one inside all of them (a tiny 2D linear program).
+// Two moving drones each take half of the dodge. Idle drones don't move out of the way (DroneComponent::update() keeps
+// them still), so whoever walks into them takes all of it.
+// Neighbours are taken at the velocity their path asks for this tick, not the one they end up with.
+// Velocities here are in pixels per second, the transforms store them as a direction scaled by their speed.
+// The pushing apart in DroneComponent::handleDynamicCollisions() is still there for whatever can't be avoided.
+class CrowdAvoidance {
+private:
+    struct Line {
+        Vector2D point;
+        Vector2D direction;
+    };
+    struct Neighbour {
+        DroneComponent* drone;
+        float distance_2;
+    };
+
+    SpatialGrid grid;
+    std::vector<Entity*> candidates = {}; // scratch, reused every drone
+    std::vector<Neighbour> neighbours = {};
+    std::vector<Line> lines = {};
+    std::vector<Line> projected_lines = {};
+    std::vector<Vector2D> new_velocities = {};
+
+    static constexpr float EPSILON = 0.00001f;
+
+    static float det(const Vector2D& a, const Vector2D& b) { return a.x*b.y - a.y*b.x; }
+
+    // velocity on lines[line_no] closest to `preferred` (or furthest along it with `direction_opt`) that's inside every
+    // line before it and the max speed circle. false if there's none
+    static bool linearProgram1(const std::vector<Line>& lines, size_t line_no, float max_speed, const Vector2D& preferred, bool direction_opt, Vector2D& result) {
+        const Line& line = lines[line_no];
+        const float dot = DotProd(line.point, line.direction);
+        const float discriminant = dot*dot + max_speed*max_speed - DotProd(line.point, line.point);
+        if(discriminant < 0.0f) { return false; } // the max speed circle doesn't reach the line
+
+        const float sqrt_discriminant = std::sqrt(discriminant);
+        float t_left = -dot - sqrt_discriminant;
+        float t_right = -dot + sqrt_discriminant;
+        for(size_t i=0; i<line_no; ++i) {
+            const float denominator = det(line.direction, lines[i].direction);
+            const float numerator = det(lines[i].direction, line.point - lines[i].point);
+            if(std::fabs(denominator) <= EPSILON) { // parallel
+                if(numerator < 0.0f) { return false; }
+                continue;
+            }
+            const float t = numerator / denominator;
+            if(denominator >= 0.0f) {
+                t_right = std::min(t_right, t);
+            } else {
+                t_left = std::max(t_left, t);
+            }
+            if(t_left > t_right) { return false; }
+        }
+
+        if(direction_opt) {
+            result = line.point + line.direction * (DotProd(preferred, line.direction) > 0.0f ? t_right : t_left);
+        } else {
+            const float t = std::clamp(DotProd(line.direction, preferred - line.point), t_left, t_right);
+            result = line.point + line.direction * t;
+        }
+        return true;
+    }
+
+    // returns lines.size() on success, otherwise the line it failed on (result is the best velocity before it)
+    static size_t linearProgram2(const std::vector<Line>& lines, float max_speed, const Vector2D& preferred, bool direction_opt, Vector2D& result) {
+        if(direction_opt) {
+            result = preferred * max_speed; // `preferred` is a unit vector in this case
+        } else if(DotProd(preferred, preferred) > max_speed*max_speed) {
+            Vector2D p = preferred;
+            result = p.Normalize() * max_speed;
+        } else {
+            result = preferred;
+        }
+        for(size_t i=0; i<lines.size(); ++i) {
+            if(det(lines[i].direction, lines[i].point - result) > 0.0f) { // result is outside this half-plane
+                const Vector2D previous = result;
+                if(!linearProgram1(lines, i, max_speed, preferred, direction_opt, result)) {
+                    result = previous;
+                    return i;
+                }
+            }
+        }
+        return lines.size();
+    }
+
+    // too crowded for every constraint at once: the velocity that breaks them the least
+    void linearProgram3(size_t begin_line, float max_speed, Vector2D& result) {
+        float distance = 0.0f;
+        for(size_t i=begin_line; i<this->lines.size(); ++i) {
+            const Line& line = this->lines[i];
+            if(det(line.direction, line.point - result) <= distance) { continue; }
+
+            this->projected_lines.clear();
+            for(size_t j=0; j<i; ++j) {
+                const Line& other = this->lines[j];
+                Line projected;
+                const float determinant = det(line.direction, other.direction);
+                if(std::fabs(determinant) <= EPSILON) {
+                    if(DotProd(line.direction, other.direction) > 0.0f) { continue; } // same direction
+                    projected.point = (line.point + other.point) * 0.5f;
+                } else {
+                    projected.point = line.point + line.direction * (det(other.direction, line.point - other.point) / determinant);
+                }
+                Vector2D direction = other.direction - line.direction;
+                projected.direction = direction.Normalize();
+                this->projected_lines.push_back(projected);
+            }
+
+            const Vector2D previous = result;
+            if(linearProgram2(this->projected_lines, max_speed, Vector2D(-line.direction.y, line.direction.x), true, result) < this->projected_lines.size()) {
+                result = previous; // can only fail because of rounding
+            }
+            distance = det(line.direction, line.point - result);
+        }
+    }
+
+    // the half-plane of velocities that keep `a` from hitting `b` within TIME_HORIZON
+    static Line orcaLine(const DroneComponent& a, const Vector2D& a_position, const Vector2D& a_velocity, const DroneComponent& b, const Vector2D& b_position, const Vector2D& b_velocity, float responsibility) {
+        const Vector2D relative_position = b_position - a_position;
+        const Vector2D relative_velocity = a_velocity - b_velocity;
+        const float distance_2 = DotProd(relative_position, relative_position);
+        const float combined_radius = a.radius + b.radius;
+        const float combined_radius_2 = combined_radius * combined_radius;
+        const float inv_time_horizon = 1.0f / TIME_HORIZON;
+
+        Line line;
+        Vector2D u;
+        if(distance_2 > combined_radius_2) {
+            // vector from the cutoff center to the relative velocity
+            Vector2D w = relative_velocity - relative_position * inv_time_horizon;
+            const float w_length_2 = DotProd(w, w);
+            const float dot = DotProd(w, relative_position);
+            if(dot < 0.0f && dot*dot > combined_radius_2 * w_length_2) {
+                // closest to the cutoff circle
+                const float w_length = std::sqrt(w_length_2);
+                const Vector2D unit_w = w * (1.0f / w_length);
+                line.direction = Vector2D(unit_w.y, -unit_w.x);
+                u = unit_w * (combined_radius * inv_time_horizon - w_length);
+            } else {
+                // closest to one of the legs of the cone
+                const float leg = std::sqrt(distance_2 - combined_radius_2);
+                if(det(relative_position, w) > 0.0f) {
+                    line.direction = Vector2D(
+                        relative_position.x*leg - relative_position.y*combined_radius,
+                        relative_position.x*combined_radius + relative_position.y*leg
+                    ) * (1.0f / distance_2);
+                } else {
+                    line.direction = Vector2D(
+                        -(relative_position.x*leg + relative_position.y*combined_radius),
+                        -(-relative_position.x*combined_radius + relative_position.y*leg)
+                    ) * (1.0f / distance_2);
+                }
+                u = line.direction * DotProd(relative_velocity, line.direction) - relative_velocity;
+            }
+        } else {
+            // already overlapping, get out of each other within a tick
+            const float inv_tick = 1.0f / Game::TICK_DELTA;
+            Vector2D w = relative_velocity - relative_position * inv_tick;
+            const float w_length = w.Magnitude();
+            const Vector2D unit_w = w_length > 0.0f ? w * (1.0f / w_length) : Vector2D(0.0f, 0.0f);
+            line.direction = Vector2D(unit_w.y, -unit_w.x);
+            u = unit_w * (combined_radius * inv_tick - w_length);
+        }
+        line.point = a_velocity + u * responsibility;
+        return line;
+    }
+
+    static Vector2D velocityOf(const DroneComponent& d) { return d.transform->velocity * d.transform->speed; }
+    static bool moving(const DroneComponent& d) { return d.preUpdating; }
+
+public:
+    static constexpr float TIME_HORIZON = 1.0f;   // seconds ahead collisions are avoided
+    static constexpr int MAX_NEIGHBOURS = 10;     // closest ones only, so packed groups cost the same per drone
+    float neighbour_distance = 5.0f * Game::UNIT_SIZE;
+
+    CrowdAvoidance() {}
+
+    void setWorldBounds(float world_width, float world_height) {
+        this->grid.setBounds(world_width, world_height, this->neighbour_distance);
+    }
+
+    void clear() { this->grid.clear(); }
+
+    // buckets the drones where they are now, for apply() and touching()
+    void index(const std::vector<Entity*>& drones) { this->grid.build(drones); }
+
+    // swaps every moving drone's velocity for the closest one to it that doesn't run into its neighbours
+    void apply(const std::vector<Entity*>& drones) {
+        index(drones);
+        this->new_velocities.resize(drones.size());
+        const float neighbour_distance_2 = this->neighbour_distance * this->neighbour_distance;
+
+        // every new velocity is worked out from the old ones, so the drones' order doesn't matter
+        for(size_t i=0; i<drones.size(); ++i) {
+            DroneComponent& drone = drones[i]->getComponent<DroneComponent>();
+            const Vector2D preferred = velocityOf(drone);
+            this->new_velocities[i] = preferred;
+            if(!moving(drone)) { continue; }
+
+            const Vector2D position = drone.transform->getCenter();
+            this->candidates.clear();
+            this->grid.queryRadius(position, this->neighbour_distance, this->candidates);
+            this->neighbours.clear();
+            for(Entity* e : this->candidates) {
+                if(e == drones[i]) { continue; }
+                DroneComponent& other = e->getComponent<DroneComponent>();
+                const float distance_2 = Distance(position, other.transform->getCenter());
+                if(distance_2 > neighbour_distance_2) { continue; }
+                // keep the MAX_NEIGHBOURS closest, sorted
+                if(this->neighbours.size() == MAX_NEIGHBOURS && distance_2 >= this->neighbours.back().distance_2) { continue; }
+                if(this->neighbours.size() < MAX_NEIGHBOURS) { this->neighbours.push_back({ &other, distance_2 }); }
+                size_t n = this->neighbours.size() - 1;
+                while(n > 0 && this->neighbours[n-1].distance_2 > distance_2) {
+                    this->neighbours[n] = this->neighbours[n-1];
+                    --n;
+                }
+                this->neighbours[n] = { &other, distance_2 };
+            }
+            if(this->neighbours.empty()) { continue; }
+
+            this->lines.clear();
+            for(const Neighbour& n : this->neighbours) {
+                const float responsibility = moving(*n.drone) ? 0.5f : 1.0f;
+                this->lines.push_back(orcaLine(drone, position, preferred, *n.drone, n.drone->transform->getCenter(), velocityOf(*n.drone), responsibility));
+            }
+            const float max_speed = std::sqrt(DotProd(preferred, preferred));
+            Vector2D result;
+            const size_t failed_line = linearProgram2(this->lines, max_speed, preferred, false, result);
+            if(failed_line < this->lines.size()) { linearProgram3(failed_line, max_speed, result); }
+            this->new_velocities[i] = result;
+        }
+
+        for(size_t i=0; i<drones.size(); ++i) {
+            DroneComponent& drone = drones[i]->getComponent<DroneComponent>();
+            if(!moving(drone) || drone.transform->speed <= 0.0f) { continue; }
+            drone.transform->velocity = this->new_velocities[i] * (1.0f / drone.transform->speed);
+        }
+    }
+
+    // every drone whose circle could touch `drone`'s as of the last index(), `drone` included
+    void touching(Entity* drone, std::vector<Entity*>& out) const {
+        DroneComponent& d = drone->getComponent<DroneComponent>();
+        out.clear();
+        this->grid.queryRadius(d.transform->getCenter(), d.radius, out);
+    }
+};
@@ -8,6 +8,7 @@
 #include "SpriteComponent.hpp"
 #include "Colliders/Collider.hpp"
 #include "Colliders/Collision.hpp"
+#include "PathFollower.hpp"
 
 // return a translation vector to be applied to the movable object transform;
 // assumes ALL entities are stationaries EXCEPT for the dynamic_col
@@ -68,13 +69,12 @@ float offcourse_limit_with_diameter;
 
 void setPathToMove(const std::vector<Vector2D>& new_path, const float& new_limit) {
     if(new_path.size() == 0) { return; }
-    this->path = new_path;
+    this->path.assign(new_path.begin(), new_path.end()); // keeps the capacity of the last path
     this->cum_translation = Vector2D(0,0);
     this->destination_position = new_path[0];
-    this->visited_indices = {};
     this->transform->velocity = Vector2D(0,0);
-    this->last_path_index = this->path.size() - 1;
-    this->current_path_index = this->last_path_index;
+    // Leaving these 2* because of the offset when sliding over blocked tiles. Also it kinda makes the trajectory "look smoother"
+    this->follower.set(this->path, 2*this->radius_squared, this->radius_squared, this->radius);
     this->preUpdating = true;
     this->offcourse_limit = new_limit;
     this->offcourse_limit_with_diameter = new_limit * this->diameter*this->diameter;
@@ -85,20 +85,21 @@ TransformComponent *transform;
 SpriteComponent *sprite;
 Collider *collider;
 MainColors color_type; // used to distinguish between players
+uint32_t net_id = 0; // index in Game::drones_by_net_id
 
 bool selected = false;
 bool preUpdating = false;
 Vector2D destination_position;
 std::vector<Vector2D> path = {};
-std::vector<int> visited_indices = {};
-int current_path_index = -1;
-int last_path_index = -1;
+PathFollower follower; // its cursor is the index in path being moved to
 float radius;
 float radius_squared;
 float diameter;
 float offcourse_limit;
 
 float speed_modifier = 1.0f;
+int tech_level = 0; // what it can cross and at what cost, see TerrainCosts::forTechLevel(). Set before it gets orders
+PathSearch path_search = PathSearch::A_STAR; // how its paths are searched, comes with each order (MoveOrder::search)
 
 
 DroneComponent(const Vector2D& starting_position, float diameter, SDL_Texture* sprite_texture, MainColors c) {
@@ -132,9 +133,13 @@ void updateDynamicTranslation(const Vector2D& v) {
     else { this->dynamic_translation.y += v.y; }
 }
 
+const TerrainCosts& terrainCosts() const {
+    return TerrainCosts::forTechLevel(this->tech_level);
+}
+
 void moveToPoint(const Vector2D& destination) {
     float new_offcourse_limit;
-    std::vector<Vector2D> new_path = find_path(getPosition(), destination, new_offcourse_limit);
+    std::vector<Vector2D> new_path = find_path(getPosition(), destination, new_offcourse_limit, terrainCosts(), this->path_search);
     setPathToMove(new_path, new_offcourse_limit);
 }
 
@@ -152,75 +157,15 @@ void init() override {
 }
 
 void preUpdate() override {
-    // no more points to follow
-    if(this->current_path_index == -1 && path.size() > 0 && visited_indices.size() == path.size()) {
-        this->path = {};
-        this->visited_indices = {};
-        this->current_path_index = -1;
+    if(!this->follower.following()) { return; }
+    Vector2D target;
+    if(this->follower.step(this->path, getPosition(), target)) {
+        this->transform->velocity = (target - getPosition()).Normalize() * 2.0f;
+    } else { // no more points to follow
+        this->path.clear();
         this->transform->velocity = Vector2D(0,0);
         this->preUpdating = false;
     }
-    
-    if( // edge case for first point
-        this->current_path_index > 0 &&
-        this->current_path_index == this->last_path_index &&
-        Distance(getPosition(), path[this->current_path_index]) > (this->radius_squared) &&
-        this->transform->velocity.x == 0.0f && this->transform->velocity.y == 0.0f
-    ) {
-        this->transform->velocity = (this->path[current_path_index] - getPosition()).Normalize() * 2.0f;
-    } else if( // has reached new point. Leaving these 2* because of the offset when sliding over blocked tiles. Also it kinda makes the trajectory "look smoother"
-        this->current_path_index > 0 && 
-        Distance(getPosition(), path[this->current_path_index]) <= 2*(this->radius_squared)
-    ) {
-        float d;
-        std::vector<int> candidate_indices = {};
-
-        // mark every node inside the circle as visited
-        for(int i=this->last_path_index; i>=0; --i) {
-            if(std::find(visited_indices.begin(), visited_indices.end(), i) == visited_indices.end()) {
-                d = Distance(getPosition(), path[i]);
-                if(d <= 2*(this->radius_squared)) {
-                    visited_indices.push_back(i);
-                    candidate_indices.push_back(i);
-                }
-            }
-        }
-        
-        int min_idx = this->last_path_index;
-        // get the min index of the nodes inside the circle -> the node which is farther along the path
-        for(int i=0; i<candidate_indices.size(); ++i) {
-            if(candidate_indices[i] < min_idx) { min_idx = candidate_indices[i];}
-        }
-        // the next one should thus be outside the circle and should serve as the next destination
-        this->current_path_index = min_idx - 1;
-        this->transform->velocity = (this->path[current_path_index] - getPosition()).Normalize() * 2.0f;
-    } else if(
-        this->current_path_index == 0 && 
-        Distance(getPosition(), path[this->current_path_index]) <= (this->radius_squared) // exception distance for last point (destination)
-    ) {
-        float d;
-        std::vector<int> candidate_indices = {};
-
-        // mark every node inside the circle as visited
-        for(int i=this->last_path_index; i>=0; --i) {
-            if(std::find(visited_indices.begin(), visited_indices.end(), i) == visited_indices.end()) {
-                d = Distance(getPosition(), path[i]);
-                if(d <= (this->radius_squared)) {
-                    visited_indices.push_back(i);
-                    candidate_indices.push_back(i);
-                }
-            }
-        }
-        
-        int min_idx = this->last_path_index;
-        // get the min index of the nodes inside the circle -> the node which is farther along the path
-        for(int i=0; i<candidate_indices.size(); ++i) {
-            if(candidate_indices[i] < min_idx) { min_idx = candidate_indices[i];}
-        }
-        // the next one should thus be outside the circle and should serve as the next destination
-        this->current_path_index = min_idx - 1;
-        this->transform->velocity = (this->path[current_path_index] - getPosition()).Normalize() * 2.0f;
-    }
 }
 
 void update() override {
@@ -229,9 +174,12 @@ void update() override {
         this->transform->velocity = Vector2D(0,0);
     }
 
+    // as slow as the path finding thinks the tile is
     MeshNode current_mesh_node = convertVector2DToMeshNode(getPosition(), 1);
-    if(Game::collision_mesh_1[current_mesh_node.y][current_mesh_node.x] == TILE_ROUGH) {
-        this->speed_modifier = 0.5f;
+    const TerrainCosts& costs = terrainCosts();
+    const uint8_t tile = Game::collision_mesh_1[current_mesh_node.y][current_mesh_node.x];
+    if(costs.walkable(tile)) {
+        this->speed_modifier = 1.0f / costs.multiplier[tile];
     } else {
         this->speed_modifier = 1.0f;
     }
@@ -300,7 +248,8 @@ void handleDynamicCollisions(const std::vector<Entity*>& drones) {
 }
 
 // hopefully when this is called, there should be no new dynamic_translations afterwards
-void handleCollisionTranslations() {
+// `allow_retrace`: false to never search for a new path from here (e.g. while replaying ticks for prediction)
+void handleCollisionTranslations(bool allow_retrace = true) {
     Vector2D translation = Vector2D(0,0);
     // on X
     if(this->static_translation.x > 0) {
@@ -328,8 +277,9 @@ void handleCollisionTranslations() {
 
     // retrace the path if it went VERY off course (purely eyeballed)
     if(
-        (this->current_path_index != -1 && this->path.size() > 0) && 
-        Distance(this->path[this->current_path_index], this->getPosition()) > this->offcourse_limit_with_diameter
+        allow_retrace &&
+        this->follower.following() && 
+        Distance(this->path[this->follower.cursor], this->getPosition()) > this->offcourse_limit_with_diameter
     ) {
         printf("RETRACE\n");
         this->moveToPoint(this->destination_position);
@@ -338,9 +288,12 @@ void handleCollisionTranslations() {
     this->static_translation = Vector2D(0,0);
     this->dynamic_translation = Vector2D(0,0);
 
-    entity->getComponent<TextComponent>().setText(
-        this->transform->position.FormatDecimal(4,0)
-    );
+    // headless drones don't carry the debug label
+    if(entity->hasComponent<TextComponent>()) {
+        entity->getComponent<TextComponent>().setText(
+            this->transform->position.FormatDecimal(4,0)
+        );
+    }
 }
 
 void handleOutOfBounds(float max_x, float max_y) {
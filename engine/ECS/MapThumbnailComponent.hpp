@@ -39,7 +39,7 @@ void setObjects(float pos_x, float pos_y, float w, float h, const std::string& n
         w, h
     };
     this->map_dimensions_subtitle = new TextComponent(
-        std::to_string(this->map_width)+" x "+std::to_string(this->map_height),
+        this->map_width > 0 ? std::to_string(this->map_width)+" x "+std::to_string(this->map_height) : "...",
         pos_x, 
         this->border_rect.y + this->border_rect.h + this->thumbnail_gap,
         Game::default_text_color, true
@@ -92,7 +92,7 @@ const int thumbnail_gap = 4;
 const int border_thickness = 2;
 const int double_thickness = this->border_thickness<<1;
 uint32_t map_width, map_height;
-std::vector<std::vector<SDL_Color>> map_pixels = {};
+MapPixels map_pixels = {};
 std::string map_name = "Placeholder";
 SDL_FRect map_rect;
 SDL_FRect border_rect;
@@ -105,15 +105,12 @@ bool draw_camera = false;
 float minimap_proportion_width;
 float minimap_proportion_height;
 
-MapThumbnailComponent(const std::string& map_dir, const std::string& map_name, float pos_x, float pos_y, float scale=1.0f) {
-    const std::string file_path = map_dir+map_name+".bmp";
-    if(getBMPProperties(file_path, &this->map_width, &this->map_height)) {
-        this->map_texture = TextureManager::LoadTexture(file_path.c_str());
-        const float scaled_size = this->thumbnail_side_size * scale;
-        setObjects(pos_x, pos_y, scaled_size, scaled_size, map_name);
-    } else {
-        throw std::runtime_error("Failed to get BMP properties for MapThumbnail: " + file_path);
-    }    
+// nothing is read here, the image comes later through setThumbnail() (see ThumbnailLoader)
+MapThumbnailComponent(const std::string& map_name, float pos_x, float pos_y, float scale=1.0f) {
+    this->map_width = 0;
+    this->map_height = 0;
+    const float scaled_size = this->thumbnail_side_size * scale;
+    setObjects(pos_x, pos_y, scaled_size, scaled_size, map_name);
 }
 MapThumbnailComponent(const std::string& map_dir, const std::string& map_name, float pos_x, float pos_y, float width, float height) {
     const std::string file_path = map_dir+map_name+".bmp";
@@ -129,7 +126,7 @@ MapThumbnailComponent(const std::string& map_dir, const std::string& map_name, f
 MapThumbnailComponent(
     std::vector<Entity*>* buildings, 
     std::vector<Entity*>* drones, 
-    const std::vector<std::vector<SDL_Color>>& bmp_pixels, 
+    const MapPixels& bmp_pixels, 
     const std::vector<std::pair<int, int>>& spawn_positions,
     float pos_x, float pos_y, float width, float height
 ) {
@@ -137,8 +134,8 @@ MapThumbnailComponent(
     this->drones = drones;
     this->draw_camera = true;
     this->map_pixels = bmp_pixels;
-    this->map_height = bmp_pixels.size();
-    this->map_width = bmp_pixels[0].size();
+    this->map_height = bmp_pixels.height;
+    this->map_width = bmp_pixels.width;
     // all base spawns are always PLAIN terrain, recolor it for minimap
     for(const std::pair<int, int>& pair : spawn_positions) {
         this->map_pixels[pair.first][pair.second] = COLORS_PLAIN;
@@ -175,6 +172,22 @@ MapThumbnailComponent(
     }
 }
 
+/**
+ * takes ownership of `texture` (already scaled down) and shows the map's size. A null texture means the map couldn't be read
+ * `width`, `height`: size of the map itself, not of the texture
+ */
+void setThumbnail(SDL_Texture* texture, uint32_t width, uint32_t height) {
+    if(this->map_texture) { SDL_DestroyTexture(this->map_texture); }
+    this->map_texture = texture;
+    this->map_width = width;
+    this->map_height = height;
+    this->map_dimensions_subtitle->setText(texture ? std::to_string(width)+" x "+std::to_string(height) : "unreadable map");
+    this->map_dimensions_subtitle->setRenderPos(
+        this->map_dimensions_subtitle->x, this->map_dimensions_subtitle->y,
+        this->map_dimensions_subtitle->w, this->map_dimensions_subtitle->h
+    );
+}
+
 /**
  * moves the camera to center where the player clicked, returns false if minimap was not clicked 
  * `bx`: button x coordinate
@@ -251,11 +264,8 @@ void draw() override {
         get the camera world position
         scale it by the minimap proportions
         */
-        std::vector<Vector2D> screen_corners = std::vector<Vector2D>(4);
-        screen_corners[0] = convertScreenToWorld({                                   0.0f,                                    0.0f });
-        screen_corners[1] = convertScreenToWorld({ static_cast<float>(Game::SCREEN_WIDTH),                                    0.0f });
-        screen_corners[2] = convertScreenToWorld({ static_cast<float>(Game::SCREEN_WIDTH), static_cast<float>(Game::SCREEN_HEIGHT) });
-        screen_corners[3] = convertScreenToWorld({                                   0.0f, static_cast<float>(Game::SCREEN_HEIGHT) });
+        Vector2D screen_corners[4];
+        Camera::getScreenCornersInWorld(screen_corners);
         for(int i=0; i<4; ++i) {
             this->camera_points[i] = this->convertWorldToMinimap(screen_corners[i]);
         }
@@ -275,7 +285,7 @@ void draw() override {
         TextureManager::DrawRect(&this->border_rect, this->border_color);
 
         if(this->use_texture) {
-            TextureManager::Draw(this->map_texture, NULL, &this->map_rect);
+            if(this->map_texture) { TextureManager::Draw(this->map_texture, NULL, &this->map_rect); }
         } else {
             SDL_FRect pixel_rect = { 0.0f, 0.0f, this->pixel_width, this->pixel_height };
             int y, x;
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "../Vector2D.hpp"
+
+// Steering along a path the way find_path() returns it: destination at [0], start at the back. The cursor is the
+// waypoint being steered to and only ever counts down, so a step never looks at more than a few waypoints no matter how
+// long the path is, and nothing is allocated after the path is set.
+// Instead of aiming at the waypoint itself, the position is projected on the segment it's on and the steering target is
+// `lookahead` further along the path from there. That cuts the corners a bit, and brings the drone back onto the segment
+// when collisions push it sideways.
+class PathFollower {
+public:
+static const int MAX_ADVANCE = 4; // waypoints the cursor may skip per step
+
+int cursor = -1; // -1 without a path or once it's done
+float reach_squared = 0.0f;  // waypoints this close are reached
+float arrive_squared = 0.0f; // same for the destination
+float lookahead = 0.0f;
+
+void set(const std::vector<Vector2D>& path, float reach_squared, float arrive_squared, float lookahead) {
+    this->cursor = static_cast<int>(path.size()) - 1;
+    this->reach_squared = reach_squared;
+    this->arrive_squared = arrive_squared;
+    this->lookahead = lookahead;
+}
+
+void clear() { this->cursor = -1; }
+
+bool following() const { return this->cursor >= 0; }
+
+/**
+ * moves the cursor past the waypoints already reached (or passed) and sets `out_target` to the point to steer at.
+ * returns false once the destination is reached, the cursor is -1 from then on
+ */
+bool step(const std::vector<Vector2D>& path, const Vector2D& position, Vector2D& out_target) {
+    if(this->cursor < 0 || this->cursor >= static_cast<int>(path.size())) {
+        this->cursor = -1;
+        return false;
+    }
+    for(int advanced=0; advanced<MAX_ADVANCE && this->cursor > 0 && passed(path, position); ++advanced) {
+        --this->cursor;
+    }
+    if(this->cursor == 0 && Distance(position, path[0]) <= this->arrive_squared) {
+        this->cursor = -1;
+        return false;
+    }
+    out_target = target(path, position);
+    return true;
+}
+
+private:
+// reached the cursor's waypoint, or went beyond it along its segment
+bool passed(const std::vector<Vector2D>& path, const Vector2D& position) const {
+    const Vector2D& waypoint = path[this->cursor];
+    if(Distance(position, waypoint) <= this->reach_squared) { return true; }
+    if(this->cursor + 1 >= static_cast<int>(path.size())) { return false; } // first waypoint, there's no segment yet
+    return DotProd(position - waypoint, waypoint - path[this->cursor + 1]) > 0.0f;
+}
+
+Vector2D target(const std::vector<Vector2D>& path, const Vector2D& position) const {
+    const Vector2D& b = path[this->cursor];
+    if(this->cursor + 1 >= static_cast<int>(path.size())) { return b; }
+    const Vector2D& a = path[this->cursor + 1];
+
+    // closest point to `position` on a -> b
+    Vector2D segment = b - a;
+    const float length_squared = segment.Magnitude2();
+    float t = length_squared > 0.0f ? DotProd(position - a, segment) / length_squared : 1.0f;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    const Vector2D projection = a + segment * t;
+
+    // then `lookahead` along the path, into the next segment if this one is shorter than that
+    Vector2D rest = b - projection;
+    const float remaining = rest.Magnitude();
+    if(remaining >= this->lookahead) { return projection + rest.Normalize() * this->lookahead; }
+    if(this->cursor == 0) { return b; }
+    Vector2D next = path[this->cursor - 1] - b;
+    const float next_length = next.Magnitude();
+    return b + next.Normalize() * std::min(this->lookahead - remaining, next_length);
+}
+};
@@ -109,11 +109,11 @@ class TextComponent : public Component {
         }
         void draw() override {
             if(!this->fixed) {
-                Vector2D screen_pos = convertWorldToScreen(this->transform->position + this->offset);
+                Vector2D screen_pos = Camera::worldToScreen(this->transform->getRenderPosition() + this->offset);
                 this->destRect.x = screen_pos.x;
                 this->destRect.y = screen_pos.y;
-                this->destRect.w = this->w * Game::camera_zoom;
-                this->destRect.h = this->h * Game::camera_zoom;
+                this->destRect.w = this->w * Camera::scale;
+                this->destRect.h = this->h * Camera::scale;
             }
             // similar to AABB collision, but the screen has position fixed to (0,0) as well as width and height fixed to the window's dimensions
             if(
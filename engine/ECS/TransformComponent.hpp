@@ -6,6 +6,7 @@
 class TransformComponent : public Component {
     public:
         Vector2D position; // should be world coordinates
+        Vector2D previous_position; // position on the previous tick, used to interpolate when rendering
         Vector2D velocity;
 
         float height = 32.0f;
@@ -42,15 +43,25 @@ class TransformComponent : public Component {
             );
         }
 
+        // where to draw it: somewhere between the last two ticks
+        Vector2D getRenderPosition() {
+            return VecLerp(this->previous_position, this->position, Game::TICK_ALPHA);
+        }
+
         void init() override {
             this->velocity.Zero();
+            this->previous_position = this->position;
+        }
+
+        void preUpdate() override {
+            this->previous_position = this->position;
         }
 
         void update() override {
-            this->speed += this->acceleration * Game::FRAME_DELTA * 0.5f;
-            this->position.x += this->velocity.x * speed * Game::FRAME_DELTA;
-            this->position.y += this->velocity.y * speed * Game::FRAME_DELTA;
-            this->speed += this->acceleration * Game::FRAME_DELTA * 0.5f;                        
+            this->speed += this->acceleration * Game::TICK_DELTA * 0.5f;
+            this->position.x += this->velocity.x * speed * Game::TICK_DELTA;
+            this->position.y += this->velocity.y * speed * Game::TICK_DELTA;
+            this->speed += this->acceleration * Game::TICK_DELTA * 0.5f;                        
         }
 
         
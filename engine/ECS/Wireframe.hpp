@@ -2,6 +2,7 @@
 
 #include "../Camera.hpp"
 #include "ECS.hpp"
+#include "TransformComponent.hpp"
 #include "Colliders/ColliderTypes.hpp"
 #include "Colliders/Collider.hpp"
 #include "../TextureManager.hpp"
@@ -24,17 +25,15 @@ class Wireframe : public Component {
         }
 
         void refreshDrawPoints() {            
-            SDL_FPoint p;
-            Vector2D screen_pos;
-            int i;
-            for(i=0; i<amount; ++i) {
-                screen_pos = convertWorldToScreen(this->hull[i]);
-                p.x = screen_pos.x;
-                p.y = screen_pos.y;
-                this->draw_points[i] = p;
+            // hulls follow the simulated position, shift them to where the sprite is actually drawn
+            Vector2D render_offset = Vector2D(0.0f, 0.0f);
+            if(entity->hasComponent<TransformComponent>()) {
+                TransformComponent& transform = entity->getComponent<TransformComponent>();
+                render_offset = transform.getRenderPosition() - transform.position;
             }
+            Camera::worldToScreen(this->hull.data(), this->draw_points, this->amount, render_offset);
             // close the circuit
-            this->draw_points[i] = this->draw_points[0];
+            this->draw_points[this->amount] = this->draw_points[0];
         }
 
     public:
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Row major 2D array in a single allocation. Indexed as grid[y][x] (grid[y] is a pointer to the start of the row), so it
+// reads like the nested vectors it replaces, but it's one contiguous block instead of one allocation per row.
+template<typename T>
+struct FlatGrid {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<T> cells = {};
+
+    FlatGrid() {}
+    FlatGrid(uint32_t w, uint32_t h, const T& value = T()) { resize(w, h, value); }
+
+    void resize(uint32_t w, uint32_t h, const T& value = T()) {
+        this->width = w;
+        this->height = h;
+        this->cells.assign(static_cast<size_t>(w) * h, value);
+    }
+
+    T* operator[](size_t y) { return this->cells.data() + y * this->width; }
+    const T* operator[](size_t y) const { return this->cells.data() + y * this->width; }
+
+    // amount of rows, same as the outer vector's size() used to be
+    size_t size() const { return this->height; }
+    bool empty() const { return this->cells.empty(); }
+
+    T* data() { return this->cells.data(); }
+    const T* data() const { return this->cells.data(); }
+};
@@ -1,11 +1,15 @@
 #include <vector>
+#include <algorithm>
 #include <random>
 #include <map>
-#include "networking/olcPGEX_Network.h"
 #include "Game.hpp"
+#include "Colors.hpp"
+#ifndef HEADLESS
+#include "networking/olcPGEX_Network.h"
 #include "SceneTypes.hpp"
 #include "Scene.hpp"
-#include "Colors.hpp"
+#include "Camera.hpp"
+#endif
 
 int Game::MAX_FPS;
 int Game::MAX_FRAME_DELAY;
@@ -28,7 +32,13 @@ bool Game::isRunning = false;
 uint64_t Game::FRAME_COUNT;
 float Game::AVERAGE_FPS;
 float Game::FRAME_DELTA = 0.0f;
+int Game::TICK_RATE;
+float Game::TICK_DELTA;
+uint64_t Game::TICK_COUNT = 0;
+float Game::TICK_ALPHA = 0.0f;
+const int Game::MAX_TICKS_PER_FRAME = 5;
 int Game::UNIT_COUNTER = 0;
+std::vector<Entity*> Game::drones_by_net_id = {};
 
 SDL_Color Game::default_bg_color = COLORS_ROUGH;
 TTF_Font *Game::default_font;
@@ -69,6 +79,7 @@ std::string Game::EXTERNAL_IP;
 std::string Game::REMOTE_HOST_IP;
 int Game::SERVER_STATE_SHARE_RATE;
 int Game::CLIENT_PING_RATE;
+bool Game::LOCKSTEP = false;
 std::map<std::string, std::string> Game::USERS_IP;
 const std::vector<char> Game::ALLOWED_IP_CHARACTERS = { 
     '0','1','2','3','4','5','6','7','8','9',
@@ -91,8 +102,6 @@ const std::vector<char> Game::ALLOWED_NUMERICAL_CHARACTERS = {
     '0','1','2','3','4','5','6','7','8','9'
 };
 
-Scene* scene;
-
 Game::Game() {
 
 }
@@ -103,12 +112,35 @@ Game::~Game() {
 
 
 
+/**
+ * Sets up only what the simulation needs: no SDL subsystems, window, renderer, fonts or audio.
+ * tick_rate: simulation steps per second
+ * server_broadcast_rate: how many times per second the server broadcasts the drones state
+ * rng_generator: base random function pre-seeded to generate further RNG values
+*/
+void Game::initHeadless(int tick_rate, int server_broadcast_rate, std::mt19937* rng_generator) {
+    Game::TICK_RATE = tick_rate;
+    Game::TICK_DELTA = 1.0f / tick_rate;
+    Game::TICK_COUNT = 0;
+    Game::SERVER_STATE_SHARE_RATE = std::max(1, tick_rate / server_broadcast_rate);
+    Game::CLIENT_PING_RATE = tick_rate * 3;
+    Game::RNG = rng_generator;
+    Game::manager = new Manager();
+    Game::isRunning = true;
+}
+
+#ifndef HEADLESS
+Scene* scene;
+
+
+
 /**
  * title: window name
  * width and height: window proportions in pixels
  * fullscreen: force fullscreen (true fullscreen)
  * max_fps: maximum frames to be rendered per second
- * server_broadcast_rate: the amount of frames inbetween sending broadcast TCP packages
+ * tick_rate: simulation steps per second, independent of max_fps
+ * server_broadcast_rate: how many times per second the server broadcasts the drones state
  * users_ip: map of user_name to its IP string
  * rng_generator: base random function pre-seeded to generate further RNG values
 */
@@ -116,6 +148,7 @@ void Game::init(
     const char* title, 
     int width, int height, bool fullscreen,
     int max_fps, 
+    int tick_rate,
     int server_broadcast_rate, 
     std::map<std::string, std::string>& users_ip,
     std::mt19937* rng_generator
@@ -150,7 +183,9 @@ void Game::init(
 
 
     std::cout << "Subsystems Initialized\n";
-    Game::default_font = TTF_OpenFont("assets/fonts/FSEX302-alt.ttf", 16); // ideal size is 16 for this font but multiples of 8 work alright
+    AssetManager::FontHandle default_font = AssetManager::font("assets/fonts/FSEX302-alt.ttf", 16); // ideal size is 16 for this font but multiples of 8 work alright
+    Game::default_font = default_font.get();
+    AssetManager::keep(default_font);
     Game::SCREEN_WIDTH = width;
     Game::SCREEN_HEIGHT = height;
     Game::camera_focus = Vector2D(Game::SCREEN_WIDTH>>1, Game::SCREEN_HEIGHT>>1);
@@ -201,8 +236,11 @@ void Game::init(
     // Game::LIMIT_FPS = true;
     Game::MAX_FPS = max_fps;
     Game::MAX_FRAME_DELAY = 1000.0f / max_fps;
-    Game::SERVER_STATE_SHARE_RATE = max_fps / server_broadcast_rate;
-    Game::CLIENT_PING_RATE = max_fps * 3;
+    Game::TICK_RATE = tick_rate;
+    Game::TICK_DELTA = 1.0f / tick_rate;
+    // both in ticks
+    Game::SERVER_STATE_SHARE_RATE = std::max(1, tick_rate / server_broadcast_rate);
+    Game::CLIENT_PING_RATE = tick_rate * 3;
     Game::USERS_IP = users_ip;
     Game::EXTERNAL_IP = olc::net::getExternalIP();
     Game::RNG = rng_generator;
@@ -230,6 +268,7 @@ void Game::update() {
 
 void Game::render() {
     SDL_RenderClear(Game::renderer);
+    Camera::refresh();
     scene->render();
     SDL_RenderPresent(Game::renderer);
 }
@@ -237,14 +276,11 @@ void Game::render() {
 void Game::clean() {
     scene->clean();
     delete scene;
-    SDL_DestroyTexture(Game::unit_tex);
-    SDL_DestroyTexture(Game::building_tex);
-    Game::unit_tex = nullptr;
-    Game::building_tex = nullptr;
     delete Game::manager;
     Game::manager = nullptr;
     
-    TTF_CloseFont(Game::default_font);
+    // every texture, font and sound, while the renderer and the subsystems are still there
+    AssetManager::clear();
     Game::default_font = nullptr;
 
     SDL_DestroyWindow(Game::window);
@@ -257,3 +293,4 @@ void Game::clean() {
     SDL_Quit();
     std::cout << "Game cleaned\n";
 }
+#endif
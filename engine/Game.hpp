@@ -29,7 +29,14 @@ class Game {
 
         static uint64_t FRAME_COUNT;
         static float AVERAGE_FPS;
-        static float FRAME_DELTA;
+        static float FRAME_DELTA; // wall-clock seconds of the last frame. Only for presentation (camera, UI), never for the simulation
+
+        // fixed timestep simulation: update() always advances the world by TICK_DELTA
+        static int TICK_RATE; // simulation ticks per second
+        static float TICK_DELTA;
+        static uint64_t TICK_COUNT;
+        static float TICK_ALPHA; // [0,1) how far the rendered frame is between the previous tick and the current one
+        static const int MAX_TICKS_PER_FRAME; // avoids the spiral of death when a frame takes way too long
         static bool isRunning;
         static SDL_Window *window;
         static SDL_Renderer *renderer;
@@ -41,6 +48,7 @@ class Game {
         static const int UNIT_SIZE;
         static const int DOUBLE_UNIT_SIZE;
         static int UNIT_COUNTER;
+        static std::vector<Entity*> drones_by_net_id; // network id -> drone, same on the server and every client
 
         static float world_map_layout_width;
         static float world_map_layout_height;
@@ -76,6 +84,7 @@ class Game {
         static std::string REMOTE_HOST_IP;
         static int SERVER_STATE_SHARE_RATE;
         static int CLIENT_PING_RATE;
+        static bool LOCKSTEP; // multiplayer sends only the orders and every peer simulates them, see Lockstep.hpp
         static std::map<std::string, std::string> USERS_IP;
         static const std::vector<char> ALLOWED_IP_CHARACTERS;
         static const std::vector<char> ALLOWED_USERNAME_CHARACTERS;
@@ -88,10 +97,12 @@ class Game {
             const char* title, 
             int width, int height, bool fullscreen,
             int max_fps, 
+            int tick_rate,
             int server_broadcast_rate, 
             std::map<std::string, std::string>& users_ip,
             std::mt19937* rng_generator
         );
+        static void initHeadless(int tick_rate, int server_broadcast_rate, std::mt19937* rng_generator);
 
         void handleEvents();
         void update();
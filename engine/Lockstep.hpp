@@ -0,0 +1,91 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Game.hpp"
+#include "Vector2D.hpp"
+#include "ECS/ECS.hpp"
+#include "ECS/DroneComponent.hpp"
+
+// Deterministic lockstep: nobody ships drone state or paths, only the players' orders. The server stamps each order with the
+// turn it has to run on and every peer runs the same orders on the same tick of the same fixed-tick simulation, so they all
+// end up with the same world. Bandwidth depends on how much the players click, not on how many drones there are.
+// A turn is TURN_TICKS ticks and orders are scheduled INPUT_DELAY_TURNS turns ahead to hide the round trip.
+// The messages themselves are in networking/LockstepMessages.hpp
+
+struct MoveOrder {
+    std::vector<uint32_t> net_ids = {}; // ascending, so every peer moves them in the same order
+    Vector2D destination;
+    PathSearch search = PathSearch::A_STAR; // shift + right click gives quick orders, see SceneMatchGame::handleMouse()
+};
+
+class Lockstep {
+public:
+static const uint32_t TURN_TICKS = 3;
+static const uint32_t INPUT_DELAY_TURNS = 2;
+
+bool enabled = false;
+
+static uint32_t turnOf(uint64_t tick) { return static_cast<uint32_t>(tick / TURN_TICKS); }
+
+// the first INPUT_DELAY_TURNS turns can't have orders, nobody could have sent them in time
+bool turnReady(uint32_t turn) const {
+    return turn < INPUT_DELAY_TURNS || (this->has_confirmed && turn <= this->confirmed_until);
+}
+
+// turns arrive in order (TCP), so getting `turn` also confirms that every turn before it had no more orders
+void addTurn(uint32_t turn, std::vector<MoveOrder>&& orders) {
+    if(!orders.empty()) {
+        std::vector<MoveOrder>& stored = this->orders_by_turn[turn];
+        for(MoveOrder& o : orders) { stored.push_back(std::move(o)); }
+    }
+    if(!this->has_confirmed || turn > this->confirmed_until) {
+        this->confirmed_until = turn;
+        this->has_confirmed = true;
+    }
+}
+
+/**
+ * call before simulating `tick`. If it starts a turn, runs that turn's orders.
+ * returns false when the turn hasn't been confirmed by the server yet, the simulation has to wait
+ */
+bool beginTick(uint64_t tick, std::vector<Entity*>& drones_by_net_id) {
+    const uint32_t turn = turnOf(tick);
+    if(!turnReady(turn)) { return false; }
+    if(tick % TURN_TICKS != 0) { return true; }
+
+    auto it = this->orders_by_turn.find(turn);
+    if(it == this->orders_by_turn.end()) { return true; }
+    for(const MoveOrder& order : it->second) {
+        for(const uint32_t& id : order.net_ids) {
+            if(id >= drones_by_net_id.size()) { continue; }
+            DroneComponent& drone = drones_by_net_id[id]->getComponent<DroneComponent>();
+            drone.path_search = order.search;
+            drone.moveToPoint(order.destination);
+        }
+    }
+    this->orders_by_turn.erase(it);
+    return true;
+}
+
+// whole turns the server already confirmed past `tick`. A peer that fell this far behind should step faster to catch up
+uint32_t turnsBuffered(uint64_t tick) const {
+    const uint32_t turn = turnOf(tick);
+    if(!this->has_confirmed || this->confirmed_until < turn) { return 0; }
+    return this->confirmed_until - turn;
+}
+
+void reset() {
+    this->enabled = false;
+    this->orders_by_turn.clear();
+    this->confirmed_until = 0;
+    this->has_confirmed = false;
+}
+
+private:
+std::map<uint32_t, std::vector<MoveOrder>> orders_by_turn = {}; // only turns that actually have orders
+uint32_t confirmed_until = 0;
+bool has_confirmed = false;
+};
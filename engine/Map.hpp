@@ -3,7 +3,8 @@
 #include <vector>
 #include <string>
 #include <cmath>
-#include <unordered_map>
+#include <array>
+#include <memory>
 #include "utils.hpp"
 #include "Vector2D.hpp"
 #include "Game.hpp"
@@ -16,8 +17,8 @@ class Map {
 public:
 int tile_width; // in pixels
 bool loaded;
-std::vector<std::vector<int>> layout;
-std::vector<std::vector<SDL_Color>> map_pixels;
+FlatGrid<uint8_t> layout; // tile_type of every pixel, layout[y][x]
+std::shared_ptr<const MapPixels> map_pixels; // shared with whoever loaded it, never copied
 uint32_t layout_width, layout_height;
 float world_layout_width, world_layout_height;
 
@@ -31,7 +32,7 @@ SDL_Texture* water_bg_texture;
 SDL_Texture* water_fg_texture;
 
 Map(
-    const std::vector<std::vector<SDL_Color>>& pixels, 
+    std::shared_ptr<const MapPixels> pixels, 
     SDL_Texture* plain, SDL_Texture* rough, SDL_Texture* mountain, SDL_Texture* water_bg, SDL_Texture* water_fg,
     int dimension=1
 ) {
@@ -42,43 +43,9 @@ Map(
     this->water_fg_texture = water_fg;
     this->tile_width = dimension;
 
-    this->map_pixels = pixels;
-    this->layout_height = pixels.size();
-    this->layout_width = pixels[0].size();
-
-    this->world_layout_height = this->layout_height * this->tile_width;
-    this->world_layout_width = this->layout_width * this->tile_width;
-    
-    this->layout.resize(this->layout_height);
-    uint32_t x, y;    tile_type t;    SDL_Color c;
-    for(y=0; y<this->layout_height; ++y) {
-        this->layout[y].resize(this->layout_width);
-        for(x=0; x<this->layout_width; ++x) {
-            c = this->map_pixels[y][x];
-            if(isSameColor(c, COLORS_SPAWN)) { // base spawn
-                t = tile_type::TILE_BASE_SPAWN;
-            } else if(isSameColor(c, COLORS_NAVIGABLE)) { // navigable terrain
-                t = tile_type::TILE_NAVIGABLE;
-            } else if(isSameColor(c, COLORS_IMPASSABLE)) { // impassable terrain
-                t = tile_type::TILE_IMPASSABLE;
-            } else if(isSameColor(c, COLORS_ROUGH)) { // rough terrain
-                t = tile_type::TILE_ROUGH;
-            } else if(isSameColor(c, COLORS_PLAIN)) { // plain terrain
-                t = tile_type::TILE_PLAIN;
-            } else { // selected player spawn
-                t = tile_type::TILE_PLAYER;
-            }
-            this->layout[y][x] = t;
-        }
-    }
-    const float hex_x_width = 1.73205f * Game::UNIT_SIZE;
-    this->hex_grid_rect = {
-        (hex_x_width/2) - 1, 
-        static_cast<float>(Game::UNIT_SIZE),
-        this->world_layout_width - hex_x_width,
-        this->world_layout_height - (Game::UNIT_SIZE<<1)
-    };
-    this->loaded = true;
+    this->map_pixels = std::move(pixels);
+    this->loaded = this->map_pixels && !this->map_pixels->empty();
+    if(this->loaded) { classifyTiles(); }
 }
 
 Map(
@@ -99,6 +66,53 @@ Map(
 
 bool LoadMapFile(std::string& path);
 
+// tile type of a map color, anything that isn't a terrain color is a player's spawn
+static uint8_t tileFromColor(uint32_t packed_color) {
+    static const std::array<std::pair<uint32_t, uint8_t>, 5> table = {{
+        { packColor(COLORS_SPAWN),      TILE_BASE_SPAWN },
+        { packColor(COLORS_NAVIGABLE),  TILE_NAVIGABLE  },
+        { packColor(COLORS_IMPASSABLE), TILE_IMPASSABLE },
+        { packColor(COLORS_ROUGH),      TILE_ROUGH      },
+        { packColor(COLORS_PLAIN),      TILE_PLAIN      }
+    }};
+    for(const auto& [color, tile] : table) {
+        if(color == packed_color) { return tile; }
+    }
+    return TILE_PLAYER;
+}
+
+// builds layout (and the sizes) from map_pixels in a single pass over the flat buffer. Maps are mostly long runs of
+// the same color, so the last lookup is reused until the color changes
+void classifyTiles() {
+    const MapPixels& pixels = *this->map_pixels;
+    this->layout_width = pixels.width;
+    this->layout_height = pixels.height;
+    this->world_layout_height = this->layout_height * this->tile_width;
+    this->world_layout_width = this->layout_width * this->tile_width;
+
+    this->layout.resize(this->layout_width, this->layout_height);
+    const size_t amount = pixels.cells.size();
+    if(amount == 0) { return; }
+    uint32_t last_color = ~packColor(pixels.cells[0]);
+    uint8_t last_tile = TILE_PLAIN;
+    for(size_t i=0; i<amount; ++i) {
+        const uint32_t color = packColor(pixels.cells[i]);
+        if(color != last_color) {
+            last_color = color;
+            last_tile = tileFromColor(color);
+        }
+        this->layout.cells[i] = last_tile;
+    }
+
+    const float hex_x_width = 1.73205f * Game::UNIT_SIZE;
+    this->hex_grid_rect = {
+        (hex_x_width/2) - 1, 
+        static_cast<float>(Game::UNIT_SIZE),
+        this->world_layout_width - hex_x_width,
+        this->world_layout_height - (Game::UNIT_SIZE<<1)
+    };
+}
+
 int getTileFromWorldPos(Vector2D world_pos) {
     float pos_x, pos_y;
     if(world_pos.x < 0) { 
@@ -229,14 +243,9 @@ bool generateCollisionMacroMesh(const int macro_size, std::vector<std::vector<ui
     out_mesh.resize(out_height, {});
 
     int row, column;
-    std::unordered_map<uint8_t, int> tile_counter = {
-        {tile_type::TILE_BASE_SPAWN, 0},
-        {tile_type::TILE_IMPASSABLE, 0},
-        {tile_type::TILE_NAVIGABLE, 0},
-        {tile_type::TILE_PLAIN, 0},
-        {tile_type::TILE_PLAYER, 0},
-        {tile_type::TILE_ROUGH, 0}
-    };
+    // indexed by tile_type. Scanned in index order so ties always go to the same type on every machine
+    // (an unordered_map's iteration order isn't the same across standard libraries, which breaks lockstep)
+    std::array<int, tile_type::TILE_PLAYER + 1> tile_counter = {};
     std::vector<uint8_t> tiles;
     switch(inc) {
         case 4: { // I'm probably not going to use this for a long while, but maybe I'll change my mind
@@ -265,9 +274,9 @@ bool generateCollisionMacroMesh(const int macro_size, std::vector<std::vector<ui
                     for(uint8_t& t : tiles) { ++tile_counter[t]; }
                     uint8_t max_counter_type = tile_type::TILE_BASE_SPAWN;
                     int current_max = 0;
-                    for(auto& [t_type, cnt_val]: tile_counter) {
-                        if(cnt_val > current_max) { 
-                            current_max = cnt_val;
+                    for(uint8_t t_type=0; t_type<tile_counter.size(); ++t_type) {
+                        if(tile_counter[t_type] > current_max) { 
+                            current_max = tile_counter[t_type];
                             max_counter_type = t_type;    
                         }
                     }
@@ -296,9 +305,9 @@ bool generateCollisionMacroMesh(const int macro_size, std::vector<std::vector<ui
                     for(uint8_t& t : tiles) { ++tile_counter[t]; }
                     uint8_t max_counter_type = tile_type::TILE_BASE_SPAWN;
                     int current_max = 0;
-                    for(auto& [t_type, cnt_val]: tile_counter) {
-                        if(cnt_val > current_max) { 
-                            current_max = cnt_val;
+                    for(uint8_t t_type=0; t_type<tile_counter.size(); ++t_type) {
+                        if(tile_counter[t_type] > current_max) { 
+                            current_max = tile_counter[t_type];
                             max_counter_type = t_type;    
                         }
                     }
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include "HexagonGrid.hpp"
+#include "ECS/ECS.hpp"
+#include "Game.hpp"
+#include "Vector2D.hpp"
+#include "Map.hpp"
+#include "GroupLabels.hpp"
+#include "Match_utils.hpp"
+#include "Lockstep.hpp"
+#include "CompiledMap.hpp"
+#include "CrowdAvoidance.hpp"
+
+// The part of a match that has to run the same with or without a window: map, tiles, buildings, collision meshes, drones
+// and the fixed tick step. SceneMatchGame draws it, the headless runner only steps it.
+class MatchSimulation {
+private:
+SDL_Texture* plain_terrain_texture = nullptr;
+SDL_Texture* rough_terrain_texture = nullptr;
+SDL_Texture* mountain_texture = nullptr;
+SDL_Texture* water_bg_texture = nullptr;
+SDL_Texture* water_fg_texture = nullptr;
+
+std::vector<Vector2D> previous_drones_positions = {};
+std::vector<Entity*> touching_drones = {}; // scratch for the collisions between drones
+
+// between prepareLoad() and finishLoad()
+const CompiledMap* loading_compiled = nullptr; // only set when its meshes can be used
+uint32_t tile_rows_loaded = 0;
+
+public:
+Map* map = nullptr;
+std::shared_ptr<const MapPixels> map_pixels_colors = nullptr; // the same buffer the Map and the scene use
+std::vector<std::pair<int, int>> spawn_positions = {};
+
+std::vector<Entity*>& buildings = Game::manager->getGroup(groupBuildings);
+std::vector<Entity*>&    drones = Game::manager->getGroup(groupDrones);
+std::vector<Entity*>&     tiles = Game::manager->getGroup(groupTiles);
+
+CrowdAvoidance avoidance;
+uint64_t tick = 0; // ticks simulated so far. Unlike Game::TICK_COUNT it stops while waiting on a lockstep turn
+Lockstep lockstep;
+
+MatchSimulation() {}
+~MatchSimulation() { clean(); }
+
+void setTextures(SDL_Texture* plain, SDL_Texture* rough, SDL_Texture* mountain, SDL_Texture* water_bg, SDL_Texture* water_fg) {
+    this->plain_terrain_texture = plain;
+    this->rough_terrain_texture = rough;
+    this->mountain_texture = mountain;
+    this->water_bg_texture = water_bg;
+    this->water_fg_texture = water_fg;
+}
+
+Entity& AddTileOnMap(int id, float width, int map_x, int map_y, FlatGrid<uint8_t>& layout, const MapPixels& map_pixels) {
+    auto& tile(Game::manager->addEntity("tile-"+std::to_string(map_x)+','+std::to_string(map_y)));
+    tile.reserveComponents(3);
+    const float world_x = map_x * width;
+    const float world_y = map_y * width;
+
+    switch(id) {
+        case TILE_ROUGH:  {
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->rough_terrain_texture);
+        } break;
+        case TILE_IMPASSABLE: {
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->mountain_texture);
+            uint8_t* neighbors = &tile.getComponent<RectangleCollider>().adjacent_rectangles;
+            SetSolidTileNeighbors(neighbors, map_x, map_y, layout);
+        } break;
+        case TILE_NAVIGABLE: {
+            // need to be in this order to render the foreground "above" the background
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->water_bg_texture);
+            tile.addComponent<TileFGComponent>(world_x, world_y, width, width, id, this->water_fg_texture);
+        }
+        break;
+        case TILE_BASE_SPAWN: {
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture);
+            createBaseBuilding(
+                "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])),
+                world_x, world_y, width, map_pixels[map_y][map_x]
+            );
+        } break;
+        case TILE_PLAYER: {
+            // whether it created a building or not, set as TILE_PLAIN regardless
+            layout[map_y][map_x] = tile_type::TILE_PLAIN;
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture);
+
+            Vector2D tile_xy = Vector2D(map_x, map_y);
+            Vector2D tile_center = Vector2D(world_x + width/2, world_y + width/2);
+            HexPos hex_tile = convertWorldToHex(tile_center);
+            std::cout << "TILE_PLAYER placed on hex tile {" << hex_tile.q << " , " << hex_tile.r << " }\n";
+            std::vector<Vector2D> hex_hull = getPointsFromHexPos(hex_tile);
+
+            Entity* created_building = nullptr;
+
+            if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
+                Vector2D hex_center = convertHexToWorld(hex_tile);
+                std::cout << "success on first pass: " << hex_center << '\n';
+                created_building = createBaseBuilding(
+                    "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])),
+                    hex_center.x - HEX_SIDE_LENGTH, hex_center.y - HEX_SIDE_LENGTH, width, map_pixels[map_y][map_x]
+                );
+
+            } else {
+                std::cout << "else\n";
+                Vector2D hex_tile_pos = convertHexToWorld(hex_tile);
+                Vector2D neighbor_pos;
+                std::vector<HexPos> hex_neighbors = hexNeighbors(hex_tile, this->map->hex_grid_rect);
+                bool valid_spawn = false;
+                float free_pos_x, free_pos_y;
+                // first pass to prioritize spawn in same tile
+                for(HexPos& n : hex_neighbors) {
+                    neighbor_pos = convertHexToWorld(n);
+                    if(this->map->getTileCoordFromWorldPos(hex_tile_pos) == this->map->getTileCoordFromWorldPos(neighbor_pos)) {
+                        hex_hull = getPointsFromHexPos(n);
+                        if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
+                            valid_spawn = true;
+                            free_pos_x = neighbor_pos.x - HEX_SIDE_LENGTH;
+                            free_pos_y = neighbor_pos.y - HEX_SIDE_LENGTH;
+                            break;
+                        }
+                    }
+                }
+                // second pass to attempt any other free adjacent tile
+                if(!valid_spawn) {
+                    for(HexPos& n : hex_neighbors) {
+                        neighbor_pos = convertHexToWorld(n);
+                        hex_hull = getPointsFromHexPos(n);
+                        if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
+                            valid_spawn = true;
+                            free_pos_x = neighbor_pos.x - HEX_SIDE_LENGTH;
+                            free_pos_y = neighbor_pos.y - HEX_SIDE_LENGTH;
+                            break;
+                        }
+                    }
+                }
+                if(valid_spawn) {
+                    std::cout << "success on second pass: " << free_pos_x << ", " << free_pos_y << '\n';
+                    created_building = createBaseBuilding(
+                        "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])),
+                        free_pos_x, free_pos_y, width, map_pixels[map_y][map_x]
+                    );
+                } else {
+                    std::cout << "WARNING: can't create hex building from tile: " << tile_xy << '\n';
+                }
+            }
+        } break;
+        default:
+            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture);
+    }
+
+    tile.addGroup(groupTiles);
+    return tile;
+}
+// tiles (and buildings) of rows [first_row, last_row)
+void LoadMapRender(uint32_t first_row, uint32_t last_row, float tile_scale=1.0f) {
+    const float scaled_width = this->map->tile_width * tile_scale;
+    for(uint32_t row = first_row; row < last_row; ++row) {
+        for(uint32_t column = 0; column < this->map->layout_width; ++column) {
+            AddTileOnMap(
+                this->map->layout[row][column],
+                scaled_width,
+                column, row,
+                this->map->layout,
+                *this->map->map_pixels
+            );
+        }
+    }
+}
+
+// finds every COLORS_SPAWN pixel ({y, x}) and paints each one with a distinct player color, for matches without the settings screen
+static std::vector<std::pair<int, int>> assignSpawnColors(MapPixels& map_pixels) {
+    const std::vector<MainColors> possible_colors = {
+        MainColors::WHITE, MainColors::BLACK, MainColors::RED, MainColors::GREEN,
+        MainColors::BLUE, MainColors::YELLOW, MainColors::CYAN, MainColors::MAGENTA
+    };
+    std::vector<std::pair<int, int>> spawns;
+    for(int y=0; y<map_pixels.size(); ++y) {
+        for(int x=0; x<map_pixels.width; ++x) {
+            if(isSameColor(map_pixels[y][x], COLORS_SPAWN) && spawns.size() < possible_colors.size()) {
+                map_pixels[y][x] = convertMainColorToSDL(possible_colors[spawns.size()]);
+                spawns.push_back({y,x});
+            }
+        }
+    }
+    return spawns;
+}
+
+// every collision mesh from the layout and the buildings, what mapc stores in the compiled maps
+void generateCollisionMeshes() {
+    this->map->generateCollisionMesh( 1, Game::collision_mesh_1,  Game::collision_mesh_1_width,  Game::collision_mesh_1_height,  this->buildings);
+    this->map->generateCollisionMesh( 4, Game::collision_mesh_4,  Game::collision_mesh_4_width,  Game::collision_mesh_4_height,  this->buildings);
+    this->map->generateCollisionMesh(16, Game::collision_mesh_16, Game::collision_mesh_16_width, Game::collision_mesh_16_height, this->buildings);
+    this->map->generateCollisionMesh(64, Game::collision_mesh_64, Game::collision_mesh_64_width, Game::collision_mesh_64_height, this->buildings);
+    this->map->generateCollisionMacroMesh( 4, Game::collision_mesh_macro_4,  Game::collision_mesh_macro_4_width,  Game::collision_mesh_macro_4_height);
+}
+
+// ------------------------------ LOADING ------------------------------
+// load() in stages, so a scene can spread it over frames and threads:
+//   prepareLoad()           any thread, builds the Map. Doesn't touch the ECS
+//   loadTileRows()          main thread, a few rows of tiles and buildings at a time until it returns true
+//   loadCollisionMeshes()   any thread, as long as nothing adds or destroys entities meanwhile (it reads the buildings).
+//                           also measures the path finding landmarks on them
+//   finishLoad()            main thread, the drones
+/**
+ * `map_pixels`: map with the spawn pixels already painted with the players' colors. Shared, not copied
+ * `spawn_positions`: {y, x} of every spawn in the map
+ * `compiled`: the map's compiled file if it's open. Its meshes are used instead of generating them when its layout is the
+ * same. Has to stay open until loadCollisionMeshes()
+ * returns false if the map couldn't be loaded
+ */
+bool prepareLoad(std::shared_ptr<const MapPixels> map_pixels, const std::vector<std::pair<int,int>>& spawn_positions, const CompiledMap* compiled=nullptr) {
+    this->map_pixels_colors = std::move(map_pixels);
+    this->spawn_positions = spawn_positions;
+    this->map = new Map(
+        this->map_pixels_colors,
+        this->plain_terrain_texture,
+        this->rough_terrain_texture,
+        this->mountain_texture,
+        this->water_bg_texture,
+        this->water_fg_texture,
+        Game::DOUBLE_UNIT_SIZE
+    );
+    if(!this->map->loaded) { return false; }
+    // before the tiles, LoadMapRender() turns the players' spawns into TILE_PLAIN
+    this->loading_compiled = (compiled && compiled->isOpen() && compiled->matchesLayout(this->map->layout)) ? compiled : nullptr;
+    this->tile_rows_loaded = 0;
+    printf("Map  x: %d  by  y: %d\n", this->map->layout_width, this->map->layout_height);
+    return true;
+}
+
+// creates up to `rows` more rows of tiles, returns true once every row is there
+bool loadTileRows(uint32_t rows) {
+    if(this->tile_rows_loaded == 0) {
+        const int tiles_amount = this->map->layout_width * this->map->layout_height;
+        Game::manager->reserveEntities(tiles_amount);
+        this->tiles.reserve(tiles_amount);
+    }
+    const uint32_t last_row = std::min(this->map->layout_height, this->tile_rows_loaded + rows);
+    LoadMapRender(this->tile_rows_loaded, last_row);
+    this->tile_rows_loaded = last_row;
+    if(this->tile_rows_loaded < this->map->layout_height) { return false; }
+    Game::world_map_layout_width = this->map->world_layout_width;
+    Game::world_map_layout_height = this->map->world_layout_height;
+    this->avoidance.setWorldBounds(this->map->world_layout_width, this->map->world_layout_height);
+    return true;
+}
+
+// fraction of the tiles created so far
+float tilesProgress() const {
+    return (this->map && this->map->layout_height > 0) ? static_cast<float>(this->tile_rows_loaded) / this->map->layout_height : 0.0f;
+}
+
+void loadCollisionMeshes() {
+    if(this->loading_compiled) {
+        this->loading_compiled->copyCollisionMeshes();
+    } else {
+        generateCollisionMeshes();
+    }
+    this->loading_compiled = nullptr;
+    buildMeshLandmarks(TerrainCosts::forTechLevel(0));
+}
+
+void finishLoad() {
+    for(const std::pair<int,int>& pos : this->spawn_positions) {
+        MainColors c = convertSDLColorToMainColor((*this->map_pixels_colors)[pos.first][pos.second]);
+        Vector2D world_pos = this->map->getWorldPosFromTileCoord(pos.second, pos.first-1);
+        createDrone(world_pos.x, world_pos.y, c);
+    }
+}
+
+/**
+ * builds the whole match in one go: tiles, buildings, collision meshes and one drone per spawn. Same arguments as prepareLoad()
+ * returns false if the map couldn't be loaded
+ */
+bool load(std::shared_ptr<const MapPixels> map_pixels, const std::vector<std::pair<int,int>>& spawn_positions, const CompiledMap* compiled=nullptr) {
+    if(!prepareLoad(std::move(map_pixels), spawn_positions, compiled)) { return false; }
+    loadTileRows(this->map->layout_height);
+    loadCollisionMeshes();
+    finishLoad();
+    return true;
+}
+
+// advance the match by exactly one tick (Game::TICK_DELTA). Returns false if it couldn't because the lockstep turn isn't there yet
+bool step() {
+    if(this->lockstep.enabled && !this->lockstep.beginTick(this->tick, Game::drones_by_net_id)) { return false; }
+
+    this->previous_drones_positions.resize(this->drones.size());
+    for(int i=0; i<this->drones.size(); ++i) {
+        this->previous_drones_positions[i] = this->drones[i]->getComponent<TransformComponent>().position;
+    }
+
+    Game::manager->refresh();
+    Game::manager->preUpdate();
+    this->avoidance.apply(this->drones); // after the drones picked where to go, before they move
+    Game::manager->update();
+
+    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleStaticCollisions(this->previous_drones_positions[i], this->tiles, this->buildings); }
+    this->avoidance.index(this->drones);
+    for(int i=0; i<this->drones.size(); ++i) {
+        this->avoidance.touching(this->drones[i], this->touching_drones);
+        this->drones[i]->getComponent<DroneComponent>().handleDynamicCollisions(this->touching_drones);
+    }
+    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleCollisionTranslations(); }
+    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleOutOfBounds(Game::world_map_layout_width, Game::world_map_layout_height); }
+    ++this->tick;
+    return true;
+}
+
+void clean() {
+    if(this->map) {
+        delete this->map;
+        this->map = nullptr;
+    }
+    this->map_pixels_colors = nullptr;
+    this->spawn_positions = {};
+    this->previous_drones_positions = {};
+    this->avoidance.clear();
+    clearMeshLandmarks();
+    this->loading_compiled = nullptr;
+    this->tile_rows_loaded = 0;
+    this->tick = 0;
+    this->lockstep.reset();
+    Game::drones_by_net_id.clear();
+}
+};
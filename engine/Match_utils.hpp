@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Game.hpp"
+#include "utils.hpp"
+#include "Colors.hpp"
+#include "GroupLabels.hpp"
+#include "ECS/ECS.hpp"
+#include "ECS/Components.hpp"
+#include "ECS/Colliders/Collider.hpp"
+
+// Entities that make up a match. Nothing in here may depend on having a window, the headless builds (-DHEADLESS)
+// create the exact same entities minus the purely visual components.
+
+Entity* createDrone(float pos_x, float pos_y, MainColors c) {
+    auto& new_drone(Game::manager->addEntity("DRO" + left_pad_int(Game::UNIT_COUNTER, 5)));
+    new_drone.addComponent<DroneComponent>(Vector2D(pos_x, pos_y), Game::UNIT_SIZE, Game::unit_tex, c);
+    // drones are created in the same order everywhere, so the creation order works as the id over the network
+    new_drone.getComponent<DroneComponent>().net_id = Game::drones_by_net_id.size();
+    Game::drones_by_net_id.push_back(&new_drone);
+#ifndef HEADLESS
+    new_drone.addComponent<Wireframe>();
+    new_drone.addComponent<TextComponent>("", 0, 0);
+#endif
+    new_drone.addGroup(groupDrones);
+    return &new_drone;
+}
+Entity* createBaseBuilding(
+    std::string id, 
+    float world_pos_x, float world_pos_y, 
+    float width,
+    const SDL_Color& color
+) {
+    std::cout << "createBaseBuilding:" << id << " color:{" << (int)color.r << ' ' << (int)color.g << ' ' << (int)color.b << "} \n";
+    auto& building(Game::manager->addEntity(id));
+    building.addComponent<TransformComponent>(world_pos_x, world_pos_y, width, width, 1.0);
+    building.addComponent<SpriteComponent>(Game::building_tex, color);
+    building.addComponent<Collider>(ColliderType::HEXAGON);
+#ifndef HEADLESS
+    building.addComponent<Wireframe>();
+#endif
+    building.addGroup(groupBuildings);
+    return &building;
+}
+void SetSolidTileNeighbors(uint8_t* neighbors, int map_x, int map_y, const FlatGrid<uint8_t>& layout) {
+        int dec_map_x = map_x-1;
+        int inc_map_x = map_x+1;
+        int dec_map_y = map_y-1;
+        int inc_map_y = map_y+1;
+
+        bool top_left  = false;
+        bool top_mid   = false;
+        bool top_right = false;
+        bool left      = false;
+        bool right     = false;
+        bool bot_left  = false;
+        bool bot_mid   = false;
+        bool bot_right = false;
+
+        int layout_width = layout.width;
+        int layout_height = layout.size();
+
+        if(map_x == 0) {
+            if(map_y == 0) { // top left corner
+                right     = layout[    map_y][inc_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+                bot_right = layout[inc_map_y][inc_map_x] == 2;
+            } else if(map_y == layout_height-1) { // bottom left corner
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                top_right = layout[dec_map_y][inc_map_x] == 2;
+                right     = layout[    map_y][inc_map_x] == 2;
+            } else { // left column
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                top_right = layout[dec_map_y][inc_map_x] == 2;
+                right     = layout[    map_y][inc_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+                bot_right = layout[inc_map_y][inc_map_x] == 2;
+            }
+        } else if(map_x == layout_width-1) {
+            if(map_y == 0) { // top right corner
+                left      = layout[    map_y][dec_map_x] == 2;
+                bot_left  = layout[inc_map_y][dec_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+            } else if(map_y == layout_height-1) { // bottom right corner
+                top_left  = layout[dec_map_y][dec_map_x] == 2;
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                left      = layout[    map_y][dec_map_x] == 2;
+            } else { // right column
+                top_left  = layout[dec_map_y][dec_map_x] == 2;
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                left      = layout[    map_y][dec_map_x] == 2;
+                bot_left  = layout[inc_map_y][dec_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+            }
+        } else {
+            if(map_y == 0) { // top row
+                left      = layout[    map_y][dec_map_x] == 2;
+                right     = layout[    map_y][inc_map_x] == 2;
+                bot_left  = layout[inc_map_y][dec_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+                bot_right = layout[inc_map_y][inc_map_x] == 2;
+            } else if(map_y == layout_height-1) { // bottom row
+                top_left  = layout[dec_map_y][dec_map_x] == 2;
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                top_right = layout[dec_map_y][inc_map_x] == 2;
+                left      = layout[    map_y][dec_map_x] == 2;
+                right     = layout[    map_y][inc_map_x] == 2;
+            } else { // middle of the layout (most cases)
+                top_left  = layout[dec_map_y][dec_map_x] == 2;
+                top_mid   = layout[dec_map_y][    map_x] == 2;
+                top_right = layout[dec_map_y][inc_map_x] == 2;
+                left      = layout[    map_y][dec_map_x] == 2;
+                right     = layout[    map_y][inc_map_x] == 2;
+                bot_left  = layout[inc_map_y][dec_map_x] == 2;
+                bot_mid   = layout[inc_map_y][    map_x] == 2;
+                bot_right = layout[inc_map_y][inc_map_x] == 2;
+            }
+        }
+
+        setBit(neighbors, 0, top_left);
+        setBit(neighbors, 1, top_mid);
+        setBit(neighbors, 2, top_right);
+        setBit(neighbors, 3, left);
+        setBit(neighbors, 4, right);
+        setBit(neighbors, 5, bot_left);
+        setBit(neighbors, 6, bot_mid);
+        setBit(neighbors, 7, bot_right);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdint>
+#include "Vector2D.hpp"
+#include "path_finding.hpp"
+
+struct PathRequest {
+    uint32_t net_id;
+    uint32_t order; // newer orders for the same drone make older results worthless
+    Vector2D start;
+    Vector2D destination;
+    int tech_level = 0; // picks the TerrainCosts the path is searched with
+    PathSearch search = PathSearch::A_STAR;
+};
+
+struct PathResult {
+    uint32_t net_id;
+    uint32_t order;
+    float offcourse_limit;
+    std::vector<Vector2D> path;
+};
+
+// A few threads that do nothing but run find_path() so the tick doesn't stall on a big batch of move orders.
+// find_path() only reads the collision meshes, which don't change after the map is loaded.
+// submit() and collect() are called from the main thread, the results come back in whatever order they finish.
+class PathWorkers {
+private:
+std::vector<std::thread> workers = {};
+std::deque<PathRequest> requests = {};
+std::vector<PathResult> results = {};
+std::mutex requests_mutex;
+std::mutex results_mutex;
+std::condition_variable requests_cv;
+bool stopping = false;
+
+void work() {
+    PathRequest request;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(this->requests_mutex);
+            this->requests_cv.wait(lock, [this]() { return this->stopping || !this->requests.empty(); });
+            if(this->stopping) { return; }
+            request = this->requests.front();
+            this->requests.pop_front();
+        }
+        PathResult result;
+        result.net_id = request.net_id;
+        result.order = request.order;
+        result.path = find_path(request.start, request.destination, result.offcourse_limit, TerrainCosts::forTechLevel(request.tech_level), request.search);
+        {
+            std::lock_guard<std::mutex> lock(this->results_mutex);
+            this->results.push_back(std::move(result));
+        }
+    }
+}
+
+public:
+// `threads`: 0 to use every core but the one running the tick
+PathWorkers(unsigned int threads = 0) {
+    if(threads == 0) {
+        const unsigned int hc = std::thread::hardware_concurrency(); // 0 when it can't tell
+        threads = hc > 1 ? hc - 1 : 1;
+    }
+    this->workers.reserve(threads);
+    for(unsigned int i=0; i<threads; ++i) {
+        this->workers.emplace_back([this]() { work(); });
+    }
+}
+~PathWorkers() { stop(); }
+
+void submit(const std::vector<PathRequest>& batch) {
+    if(batch.empty()) { return; }
+    {
+        std::lock_guard<std::mutex> lock(this->requests_mutex);
+        this->requests.insert(this->requests.end(), batch.begin(), batch.end());
+    }
+    this->requests_cv.notify_all();
+}
+
+// moves every finished result into `out` (which is cleared first)
+void collect(std::vector<PathResult>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(this->results_mutex);
+    std::swap(out, this->results);
+}
+
+// drops anything still queued and waits for the threads to finish what they're on
+void stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->requests_mutex);
+        this->stopping = true;
+        this->requests.clear();
+    }
+    this->requests_cv.notify_all();
+    for(std::thread& t : this->workers) {
+        if(t.joinable()) { t.join(); }
+    }
+    this->workers.clear();
+}
+};
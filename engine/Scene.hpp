@@ -7,6 +7,7 @@
 #include "Map.hpp"
 #include "TextureManager.hpp"
 #include "AudioManager.hpp"
+#include "AssetManager.hpp"
 
 #include "ECS/ECS.hpp"
 #include "Colors.hpp"
@@ -29,6 +30,7 @@
 #include "SceneMainMenu.hpp"
 #include "SceneSettings.hpp"
 #include "SceneMatchGame.hpp"
+#include "SceneLoading.hpp"
 #include "SceneMatchSettings.hpp"
 #include "SceneMultiplayerSelection.hpp"
 
@@ -37,16 +39,29 @@ class Scene {
 private:
 SceneType st = SceneType::MAIN_MENU;
 SDL_Event event;
-bool load_textures = true;
 
-// ------------------ TEXTURES ------------------
-SDL_Texture* plain_terrain_texture = nullptr;
-SDL_Texture* rough_terrain_texture = nullptr;
-SDL_Texture* mountain_texture = nullptr;
-SDL_Texture* water_bg_texture = nullptr;
-SDL_Texture* water_fg_texture = nullptr;
-
-// ------------------ AUDIO ------------------
+// ------------------ ASSETS ------------------
+const std::string TEXTURE_UNIT     = "assets/white_circle.png"; // white helps with color modulation
+const std::string TEXTURE_BUILDING = "assets/white_hexagon.png";
+const std::string TEXTURE_PLAIN    = "assets/tiles/plain.png";
+const std::string TEXTURE_ROUGH    = "assets/tiles/rough.png";
+const std::string TEXTURE_MOUNTAIN = "assets/tiles/mountain.png";
+const std::string TEXTURE_WATER_BG = "assets/tiles/water_background.png";
+const std::string TEXTURE_WATER_FG = "assets/tiles/water_foreground.png";
+const std::string MUSIC_MAIN_MENU  = "assets/audio/music/f-zero-ending_theme_dsp_1.wav";
+const std::string SOUND_BUTTON     = "assets/audio/sfx/mario64-bowser_road_channel_9-noise.wav";
+
+// what each scene uses. The music keeps playing through the menus, so every scene holds it
+const SceneManifest manifest_menus          = { {},                { SOUND_BUTTON }, { MUSIC_MAIN_MENU } };
+const SceneManifest manifest_main_menu      = { { TEXTURE_PLAIN }, { SOUND_BUTTON }, { MUSIC_MAIN_MENU } };
+const SceneManifest manifest_match_settings = { { TEXTURE_UNIT },  { SOUND_BUTTON }, { MUSIC_MAIN_MENU } }; // the color dropdowns
+const SceneManifest manifest_match_game     = {
+    { TEXTURE_UNIT, TEXTURE_BUILDING, TEXTURE_PLAIN, TEXTURE_ROUGH, TEXTURE_MOUNTAIN, TEXTURE_WATER_BG, TEXTURE_WATER_FG },
+    { SOUND_BUTTON }, { MUSIC_MAIN_MENU }
+};
+std::vector<std::shared_ptr<void>> held_assets = {}; // handles of everything the current scene uses
+
+// owned by AssetManager, only valid while held_assets has them
 Mix_Music* music_main_menu = NULL;
 Mix_Chunk* sound_button = NULL;
 
@@ -57,6 +72,7 @@ SceneMatchSettings        *S_MatchSettings = nullptr;
 SceneMatchGame            *S_MatchGame = nullptr;
 SceneMultiplayerSelection *S_MultiplayerSelection = nullptr;
 SceneSettings             *S_Settings = nullptr;
+SceneLoading              *S_Loading = nullptr; // in front of S_MatchGame while it loads
 
 public:
 // frame counter
@@ -69,28 +85,15 @@ Scene() {
     this->S_MatchGame            = new SceneMatchGame(&this->event);
     this->S_MultiplayerSelection = new SceneMultiplayerSelection(&this->event);
     this->S_Settings             = new SceneSettings(&this->event);
+    this->S_Loading              = new SceneLoading(&this->event);
 }
 ~Scene() {
     Mix_HaltMusic();
-    Mix_FreeMusic(this->music_main_menu); this->music_main_menu = nullptr;
-    Mix_FreeChunk(this->sound_button);       this->sound_button = nullptr; 
-
-    if(this->plain_terrain_texture) {
-        SDL_DestroyTexture(this->plain_terrain_texture);
-        this->plain_terrain_texture = nullptr;
-    }
-    if(this->mountain_texture) {
-        SDL_DestroyTexture(this->mountain_texture);
-        this->mountain_texture = nullptr;
-    }
-    if(this->water_bg_texture) {
-        SDL_DestroyTexture(this->water_bg_texture);
-        this->water_bg_texture = nullptr;
-    }
-    if(this->water_fg_texture) {
-        SDL_DestroyTexture(this->water_fg_texture);
-        this->water_fg_texture = nullptr;
-    }
+    this->music_main_menu = nullptr;
+    this->sound_button = nullptr;
+    Game::unit_tex = nullptr;
+    Game::building_tex = nullptr;
+    this->held_assets.clear(); // AssetManager::clear() frees them
 
     delete             this->S_MainMenu;             this->S_MainMenu = nullptr;
     delete         this->S_MapSelection;         this->S_MapSelection = nullptr;
@@ -98,26 +101,53 @@ Scene() {
     delete            this->S_MatchGame;            this->S_MatchGame = nullptr;
     delete this->S_MultiplayerSelection; this->S_MultiplayerSelection = nullptr;
     delete             this->S_Settings;             this->S_Settings = nullptr;
+    delete              this->S_Loading;              this->S_Loading = nullptr;
 }
 
-void loadTextures() {
-    // white helps with color modulation
-    Game::unit_tex     = TextureManager::LoadTexture("assets/white_circle.png");
-    Game::building_tex = TextureManager::LoadTexture("assets/white_hexagon.png");
+const SceneManifest& manifestOf(SceneType t) const {
+    switch(t) {
+        case SceneType::MAIN_MENU:      return this->manifest_main_menu;
+        case SceneType::MATCH_SETTINGS: return this->manifest_match_settings;
+        case SceneType::MATCH_GAME:     return this->manifest_match_game;
+        default:                        return this->manifest_menus;
+    }
+}
 
-    this->plain_terrain_texture = TextureManager::LoadTexture("assets/tiles/plain.png");
-    this->rough_terrain_texture = TextureManager::LoadTexture("assets/tiles/rough.png");
-    this->mountain_texture      = TextureManager::LoadTexture("assets/tiles/mountain.png");
-    this->water_bg_texture      = TextureManager::LoadTexture("assets/tiles/water_background.png");
-    this->water_fg_texture      = TextureManager::LoadTexture("assets/tiles/water_foreground.png");
+// the scenes `t` can go to, their assets are decoded in the background while `t` is up
+std::vector<const SceneManifest*> nextManifests(SceneType t) const {
+    switch(t) {
+        case SceneType::MAIN_MENU:             return { &manifestOf(SceneType::MAP_SELECTION), &manifestOf(SceneType::MULTIPLAYER_SELECTION) };
+        case SceneType::MAP_SELECTION:         return { &manifestOf(SceneType::MATCH_SETTINGS) };
+        case SceneType::MATCH_SETTINGS:        return { &manifestOf(SceneType::MATCH_GAME) };
+        case SceneType::MULTIPLAYER_SELECTION: return { &manifestOf(SceneType::MATCH_GAME) };
+        default:                               return { &manifestOf(SceneType::MAIN_MENU) };
+    }
+}
 
-    this->load_textures = false;
+// takes the handles of everything scene `t` uses before letting go of the last scene's, so whatever they share isn't reloaded
+void acquireAssets(SceneType t) {
+    std::vector<std::shared_ptr<void>> previous = std::move(this->held_assets);
+    this->held_assets = AssetManager::acquire(manifestOf(t));
+    previous.clear();
+    AssetManager::releaseUnused();
+    AssetManager::preload(nextManifests(t));
+
+    // every manifest has these, they're already loaded
+    this->music_main_menu = AssetManager::music(MUSIC_MAIN_MENU).get();
+    this->sound_button = AssetManager::sound(SOUND_BUTTON).get();
+    const std::vector<std::string>& textures = manifestOf(t).textures;
+    const bool has_unit     = std::find(textures.begin(), textures.end(), TEXTURE_UNIT)     != textures.end();
+    const bool has_building = std::find(textures.begin(), textures.end(), TEXTURE_BUILDING) != textures.end();
+    Game::unit_tex     = has_unit     ? AssetManager::texture(TEXTURE_UNIT).get()     : nullptr;
+    Game::building_tex = has_building ? AssetManager::texture(TEXTURE_BUILDING).get() : nullptr;
 }
 
+// only for textures in the current scene's manifest, held_assets is what keeps it alive
+SDL_Texture* heldTexture(const std::string& path) { return AssetManager::texture(path).get(); }
+
 void setScene(SceneType t) {
-    // if this texture is null, all others are also null
-    if(Game::unit_tex == nullptr || this->load_textures) { loadTextures(); }
     this->st = t;
+    acquireAssets(t);
 
     Entity* fps_ui = createUISimpleText("FPS_COUNTER", Game::SCREEN_WIDTH - 163, 3, "FPS:000.00", Game::default_text_color, groupPriorityUI);
     this->fps_text = &fps_ui->getComponent<TextComponent>();
@@ -125,7 +155,7 @@ void setScene(SceneType t) {
     switch(t) {
         case SceneType::MAIN_MENU: { 
             this->S_MainMenu->setScene(
-                this->plain_terrain_texture, 
+                heldTexture(TEXTURE_PLAIN), 
                 this->music_main_menu,
                 this->sound_button,
                 this->fps_text
@@ -151,18 +181,21 @@ void setScene(SceneType t) {
 
         case SceneType::MATCH_GAME: {
             this->S_MatchGame->setScene(
-                this->S_MainMenu->music_main_menu,
+                this->music_main_menu,
                 this->S_MatchSettings->map_name,
                 this->S_MatchSettings->map_pixels, this->S_MatchSettings->player_sdl_color, 
                 this->S_MatchSettings->spawn_positions[this->S_MatchSettings->player_spawn_index],
                 this->S_MatchSettings->spawn_positions,
-                this->plain_terrain_texture, 
-                this->rough_terrain_texture,
-                this->mountain_texture,
-                this->water_bg_texture,
-                this->water_fg_texture,
+                heldTexture(TEXTURE_PLAIN), 
+                heldTexture(TEXTURE_ROUGH),
+                heldTexture(TEXTURE_MOUNTAIN),
+                heldTexture(TEXTURE_WATER_BG),
+                heldTexture(TEXTURE_WATER_FG),
                 this->fps_text
             );
+            // the match loads over the next frames, the loading screen is up until it's done
+            this->st = SceneType::LOADING;
+            this->S_Loading->setScene(this->fps_text, this->S_MatchGame->loadingStatus());
         } break;
 
         case SceneType::MULTIPLAYER_SELECTION: {
@@ -226,6 +259,23 @@ void handleEventsPollEvent() {
             }
         } break;
 
+        case SceneType::LOADING: {
+            this->S_Loading->handleEventsPollEvent();
+            if(this->S_Loading->cancel) {
+                this->S_MatchGame->cancelLoading();
+                this->S_Loading->cancel = false;
+            }
+            if(this->S_MatchGame->change_to_scene != SceneType::NONE) {
+                this->S_Loading->clean();
+                this->S_MatchGame->clean();
+                setScene(this->S_MatchGame->change_to_scene);
+                this->S_MatchGame->change_to_scene = SceneType::NONE;
+            } else if(this->S_MatchGame->loaded()) {
+                this->S_Loading->clean();
+                this->st = SceneType::MATCH_GAME;
+            }
+        } break;
+
         case SceneType::MATCH_GAME: {
             this->S_MatchGame->handleEventsPollEvent();
             if(this->S_MatchGame->change_to_scene != SceneType::NONE) {
@@ -272,6 +322,10 @@ void update() {
         case SceneType::MAIN_MENU: { this->S_MainMenu->update(); } break;
         case SceneType::MAP_SELECTION: { this->S_MapSelection->update(); } break;
         case SceneType::MATCH_SETTINGS: { this->S_MatchSettings->update(); } break;
+        case SceneType::LOADING: {
+            this->S_MatchGame->updateLoading();
+            this->S_Loading->setProgress(this->S_MatchGame->loadingProgress(), this->S_MatchGame->loadingStatus());
+        } break;
         case SceneType::MATCH_GAME: { this->S_MatchGame->update(); } break;
         case SceneType::MULTIPLAYER_SELECTION: { this->S_MultiplayerSelection->update(); } break;
         case SceneType::SETTINGS: { this->S_Settings->update(); } break;
@@ -284,6 +338,7 @@ void render() {
         case SceneType::MAIN_MENU: { this->S_MainMenu->render(); } break;
         case SceneType::MAP_SELECTION: { this->S_MapSelection->render(); } break;
         case SceneType::MATCH_SETTINGS: { this->S_MatchSettings->render(); } break;
+        case SceneType::LOADING: { this->S_Loading->render(); } break;
         case SceneType::MATCH_GAME: { this->S_MatchGame->render(); } break;
         case SceneType::MULTIPLAYER_SELECTION: { this->S_MultiplayerSelection->render(); } break;
         case SceneType::SETTINGS: { this->S_Settings->render(); } break;
@@ -295,6 +350,7 @@ void clean() {
         case SceneType::MAIN_MENU: { this->S_MainMenu->clean(); } break;
         case SceneType::MAP_SELECTION: { this->S_MapSelection->clean(); } break;
         case SceneType::MATCH_SETTINGS: { this->S_MatchSettings->clean(); } break;
+        case SceneType::LOADING: { this->S_Loading->clean(); this->S_MatchGame->clean(); } break;
         case SceneType::MATCH_GAME: { this->S_MatchGame->clean(); } break;
         case SceneType::MULTIPLAYER_SELECTION: { this->S_MultiplayerSelection->clean(); } break;
         case SceneType::SETTINGS: { this->S_Settings->clean(); } break;
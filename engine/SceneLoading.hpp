@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ECS/ECS.hpp"
+#include "Game.hpp"
+#include "Vector2D.hpp"
+#include "TextureManager.hpp"
+#include "SceneTypes.hpp"
+#include "Scene_utils.hpp"
+#include "Colors.hpp"
+
+// Shown while a match loads: a progress bar and what's being done. The loading itself happens elsewhere (see
+// SceneMatchGame::updateLoading()), this only keeps the window responsive meanwhile
+class SceneLoading {
+private:
+std::vector<Entity*>& pr_ui_elements = Game::manager->getGroup(groupPriorityUI);
+SDL_Event* event = nullptr;
+Entity* status_text = nullptr;
+float progress = 0.0f; // 0 to 1
+std::string status = "";
+
+const float BAR_WIDTH_RATIO = 0.5f; // of the screen width
+const float BAR_HEIGHT = 24.0f;
+
+void placeStatusText() {
+    TextComponent& text = this->status_text->getComponent<TextComponent>();
+    text.setRenderPos((Game::SCREEN_WIDTH - text.w) / 2.0f, (Game::SCREEN_HEIGHT>>1) - (text.h + this->BAR_HEIGHT), text.w, text.h);
+}
+
+public:
+TextComponent* fps_text;
+bool cancel = false; // asked to go back (ESC)
+
+SceneLoading(SDL_Event* e) { this->event = e; }
+~SceneLoading() {}
+
+void setScene(TextComponent* fps, const std::string& status) {
+    this->fps_text = fps;
+    this->progress = 0.0f;
+    this->cancel = false;
+    this->status = status;
+    this->status_text = createUISimpleText("loading_status", 0, 0, status, Game::default_text_color, groupPriorityUI);
+    placeStatusText();
+}
+
+void setProgress(float progress, const std::string& status) {
+    this->progress = std::min(std::max(progress, 0.0f), 1.0f);
+    if(status != this->status) {
+        this->status = status;
+        this->status_text->getComponent<TextComponent>().setText(status);
+        placeStatusText();
+    }
+}
+
+void handleEventsPollEvent() {
+    while( SDL_PollEvent(this->event) ) {
+        switch(this->event->type) {
+            case SDL_QUIT: {
+                Game::isRunning = false;
+                return;
+            } break;
+            case SDL_KEYUP: {
+                if(this->event->key.keysym.scancode == SDL_SCANCODE_ESCAPE) { this->cancel = true; }
+            } break;
+            case SDL_WINDOWEVENT: {
+                if(this->event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                    std::cout << "Window Size Change\n";
+                    Game::SCREEN_WIDTH = this->event->window.data1;
+                    Game::SCREEN_HEIGHT = this->event->window.data2;
+                    Game::camera_focus.x = Game::SCREEN_WIDTH>>1;
+                    Game::camera_focus.y = Game::SCREEN_HEIGHT>>1;
+                    this->fps_text->setRenderPos(Game::SCREEN_WIDTH - (this->fps_text->w+3), 3, this->fps_text->w, this->fps_text->h);
+                    placeStatusText();
+                }
+            } break;
+        }
+    }
+}
+
+void render() {
+    const float bar_width = Game::SCREEN_WIDTH * this->BAR_WIDTH_RATIO;
+    SDL_FRect bar = { (Game::SCREEN_WIDTH - bar_width) / 2.0f, Game::SCREEN_HEIGHT / 2.0f, bar_width, this->BAR_HEIGHT };
+    TextureManager::DrawRect(&bar, COLORS_BLACK);
+    SDL_FRect filled = { bar.x + 2, bar.y + 2, (bar.w - 4) * this->progress, bar.h - 4 };
+    TextureManager::DrawRect(&filled, COLORS_UI_BUTTON_BORDER_1);
+    for(auto& pr_ui : this->pr_ui_elements) { pr_ui->draw(); }
+}
+
+// only its own entities, the match keeps everything else
+void clean() {
+    if(this->status_text != nullptr) { this->status_text->destroy(); this->status_text = nullptr; }
+}
+};
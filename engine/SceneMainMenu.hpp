@@ -28,7 +28,7 @@ std::vector<Entity*> background_elements;
 SceneMainMenu(SDL_Event* e) { this->event = e; }
 ~SceneMainMenu() {}
 
-void setScene(SDL_Texture* plain_terrain, Mix_Music*& music, Mix_Chunk*& sound, TextComponent* fps) {
+void setScene(SDL_Texture* plain_terrain, Mix_Music* music, Mix_Chunk* sound, TextComponent* fps) {
     this->plain_terrain_texture = plain_terrain;
     this->music_main_menu = music;
     this->sound_button = sound;
@@ -36,12 +36,7 @@ void setScene(SDL_Texture* plain_terrain, Mix_Music*& music, Mix_Chunk*& sound,
     this->background_elements = {};
     Game::match_game_type = MatchGameType::SINGLE_PLAYER;
 
-    if(music_main_menu == nullptr) {
-        Mix_HaltMusic();
-        music = AudioManager::LoadMusic("assets/audio/music/f-zero-ending_theme_dsp_1.wav");
-        sound = AudioManager::LoadSound("assets/audio/sfx/mario64-bowser_road_channel_9-noise.wav");
-        this->music_main_menu = music;
-        this->sound_button = sound;
+    if(!Mix_PlayingMusic()) {
         Mix_PlayMusic(this->music_main_menu, -1);
     }
 
@@ -7,17 +7,27 @@
 #include "SceneTypes.hpp"
 #include "Scene_utils.hpp"
 #include "utils.hpp"
+#include "ThumbnailLoader.hpp"
 
 class SceneMapSelection {
 private:
 SceneType parent_scene;
-int thumbnail_width;
-int thumbnail_height;
+int thumbnail_width = 0;
+int thumbnail_height = 0;
 const int max_y_title = 20;
 int min_y_title = this->max_y_title;
 Entity* title = nullptr;
 Entity* button_go = nullptr;
 int maps_amount;
+const int base_x = 70;
+const int base_y = 50;
+int row_max = 1; // thumbnails per row
+int rows_amount = 0;
+const std::string maps_dir = "assets/maps/";
+std::vector<std::string> map_names = {};
+ThumbnailLoader thumbnail_loader;
+std::vector<ThumbnailResult> loaded_thumbnails = {};
+uint32_t thumbnails_generation = 0;
 
 
 std::vector<Entity*>& pr_ui_elements = Game::manager->getGroup(groupPriorityUI);
@@ -25,6 +35,33 @@ std::vector<Entity*>&    ui_elements = Game::manager->getGroup(groupUI);
 std::vector<Entity*>& bg_ui_elements = Game::manager->getGroup(groupBackgroundUI);
 SDL_Event* event;
 
+void createThumbnail(int i, int scroll) {
+    const int column = i % this->row_max;
+    const int row = i / this->row_max;
+    this->maps_thumbnails[i] = createUIMapThumbnail(
+        "thumbnail_" + std::to_string(i) + "_" + this->map_names[i], this->maps_dir, this->map_names[i],
+        this->base_x + (this->thumbnail_width * column),
+        this->base_y + (this->thumbnail_height * row) + scroll
+    );
+    MapThumbnailComponent& thumbnail = this->maps_thumbnails[i]->getComponent<MapThumbnailComponent>();
+    this->thumbnail_loader.submit({
+        static_cast<uint32_t>(i), this->thumbnails_generation, this->maps_dir, this->map_names[i], static_cast<uint32_t>(thumbnail.map_rect.w)
+    });
+}
+
+// creates the thumbnails of the rows on screen (and asks for their images), the rest wait until they're scrolled to
+void createVisibleThumbnails() {
+    const int scroll = static_cast<int>(this->title->getComponent<TextComponent>().y) - this->max_y_title;
+    for(int row=0; row<this->rows_amount; ++row) {
+        const int row_y = this->base_y + (row * this->thumbnail_height) + scroll;
+        if(row_y + this->thumbnail_height < 0 || row_y > Game::SCREEN_HEIGHT) { continue; }
+        const int last = std::min(this->maps_amount, (row+1) * this->row_max);
+        for(int i=row*this->row_max; i<last; ++i) {
+            if(this->maps_thumbnails[i] == nullptr) { createThumbnail(i, scroll); }
+        }
+    }
+}
+
 void goBack() {
     Mix_PlayChannel(-1, this->sound_button, 0);
     this->change_to_scene = this->parent_scene;
@@ -48,42 +85,28 @@ void setScene(Mix_Chunk*& sound_b, TextComponent* fps, SceneType parent) {
     
     this->selected_map_name = "";
 
-    const int base_x = 70;
-    const int base_y = 50;
-
-    this->title = createUISimpleText("select_map_title", base_x, max_y_title, "-- Map Selection --");
+    this->title = createUISimpleText("select_map_title", this->base_x, max_y_title, "-- Map Selection --");
     
-    const std::string maps_dir = "assets/maps/";
-    std::vector<std::string> map_names = getFileNamesInDirectory(maps_dir, "BMP");
-    this->maps_amount = map_names.size();
-    this->maps_thumbnails.resize(this->maps_amount, nullptr);
-
+    // only the names, no map is opened until its thumbnail is on screen
+    this->map_names = getFileNamesInDirectory(this->maps_dir, "BMP");
+    this->maps_amount = this->map_names.size();
+    this->maps_thumbnails.assign(this->maps_amount, nullptr);
+    this->rows_amount = 0;
 
-    this->maps_thumbnails[0] = createUIMapThumbnail("thumbnail_0_"+map_names[0], maps_dir, map_names[0], base_x, base_y);
-    MapThumbnailComponent& base_thumbnail = this->maps_thumbnails[0]->getComponent<MapThumbnailComponent>();
-    const int margin = 20;
-    this->thumbnail_width  = base_thumbnail.border_rect.w + margin;
-    this->thumbnail_height = base_thumbnail.border_rect.h + (Game::CHAR_HEIGHT<<1) + (base_thumbnail.thumbnail_gap<<1) + margin;
+    if(this->maps_amount > 0) {
+        createThumbnail(0, 0);
+        MapThumbnailComponent& base_thumbnail = this->maps_thumbnails[0]->getComponent<MapThumbnailComponent>();
+        const int margin = 20;
+        this->thumbnail_width  = base_thumbnail.border_rect.w + margin;
+        this->thumbnail_height = base_thumbnail.border_rect.h + (Game::CHAR_HEIGHT<<1) + (base_thumbnail.thumbnail_gap<<1) + margin;
 
-    int width_overlap = (base_x + (this->maps_amount * this->thumbnail_width)) - Game::SCREEN_WIDTH;
-    int row_max = this->maps_amount;
-    if(width_overlap > 0) {
-        row_max = this->maps_amount - std::ceil(static_cast<float>(width_overlap) / static_cast<float>(this->thumbnail_width));
-    }
-
-    int row_count = 1;
-    int y_offset = 0;
-    for(int i=1; i<this->maps_amount; ++i) {
-        if(row_count == row_max) {
-            ++y_offset;
-            row_count = 0;
+        int width_overlap = (this->base_x + (this->maps_amount * this->thumbnail_width)) - Game::SCREEN_WIDTH;
+        this->row_max = this->maps_amount;
+        if(width_overlap > 0) {
+            this->row_max = std::max(1, this->maps_amount - static_cast<int>(std::ceil(static_cast<float>(width_overlap) / static_cast<float>(this->thumbnail_width))));
         }
-        this->maps_thumbnails[i] = createUIMapThumbnail(
-            "thumbnail_" + std::to_string(i) + "_" + map_names[i], maps_dir, map_names[i],
-            base_thumbnail.origin_x + (this->thumbnail_width * row_count),
-            base_thumbnail.origin_y + (this->thumbnail_height * y_offset)
-        );
-        ++row_count;
+        this->rows_amount = (this->maps_amount + this->row_max - 1) / this->row_max;
+        createVisibleThumbnails();
     }
 
     const int back_button_y = 50;
@@ -97,7 +120,7 @@ void setScene(Mix_Chunk*& sound_b, TextComponent* fps, SceneType parent) {
         }
     );
 
-    int ui_elements_stacked_height = this->max_y_title + this->title->getComponent<TextComponent>().h + ((y_offset+1) * this->thumbnail_height);
+    int ui_elements_stacked_height = this->max_y_title + this->title->getComponent<TextComponent>().h + (this->rows_amount * this->thumbnail_height);
     int height_overlap = ui_elements_stacked_height - Game::SCREEN_HEIGHT;
     if(height_overlap > 0) {
         this->min_y_title = this->max_y_title - (height_overlap + back_button_y + back_button->getComponent<TextBoxComponent>().h);
@@ -131,6 +154,7 @@ bool clickedThumbnail(Vector2D& pos) {
                 this->thumbnail_width, this->thumbnail_height
             )) {
                 for(int i=0; i<this->maps_amount; ++i) {
+                    if(this->maps_thumbnails[i] == nullptr) { continue; }
                     MapThumbnailComponent& t = this->maps_thumbnails[i]->getComponent<MapThumbnailComponent>();
                     if(t.map_title->x == thumbnail.map_title->x && t.map_title->y == thumbnail.map_title->y) {
                         t.selected = true;
@@ -179,6 +203,7 @@ void handleMouseRelease(SDL_MouseButtonEvent& b) {
                     this->selected_map = nullptr;
                     this->selected_map_name = "";
                     for(int i=0; i<this->maps_amount; ++i) {
+                        if(this->maps_thumbnails[i] == nullptr) { continue; }
                         this->maps_thumbnails[i]->getComponent<MapThumbnailComponent>().selected = false;                        
                     }
                     if(this->button_go != nullptr) {
@@ -254,6 +279,7 @@ void handleMouseWheel(SDL_MouseWheelEvent& e) {
                     );
                 }
             }
+            createVisibleThumbnails();
         }
     }                
 }
@@ -285,6 +311,12 @@ void handleEventsPollEvent() {
 }
 void handleEventsPostPoll() {}
 void update() {
+    this->thumbnail_loader.collect(this->loaded_thumbnails);
+    for(ThumbnailResult& result : this->loaded_thumbnails) {
+        if(result.generation != this->thumbnails_generation || this->maps_thumbnails[result.index] == nullptr) { continue; }
+        SDL_Texture* texture = result.loaded ? TextureManager::LoadTextureFromPixels(result.pixels.data(), result.pixels.width, result.pixels.height) : nullptr;
+        this->maps_thumbnails[result.index]->getComponent<MapThumbnailComponent>().setThumbnail(texture, result.map_width, result.map_height);
+    }
     Game::manager->refresh();
     Game::manager->preUpdate();
     Game::manager->update();
@@ -301,10 +333,14 @@ void render() {
     for(auto& pr_ui : this->pr_ui_elements) { pr_ui->draw(); }
 }
 void clean() {
+    // whatever is still loading is for thumbnails that are about to be gone
+    this->thumbnail_loader.cancel();
+    ++this->thumbnails_generation;
     Game::manager->clearEntities();
     this->button_go = nullptr;
     this->selected_map = nullptr;    
     this->maps_thumbnails = {};
+    this->map_names = {};
     this->title = nullptr;
 }
 };
\ No newline at end of file
@@ -9,11 +9,29 @@
 #include "Map.hpp"
 #include "SceneTypes.hpp"
 #include "Scene_utils.hpp"
+#include "Visibility.hpp"
+#include "MatchSimulation.hpp"
 #include "MatchGameType.hpp"
 #include "ECS/MapThumbnailComponent.hpp"
 #include "networking/MessageTypes.h"
+#include "networking/DroneSnapshots.hpp"
 #include "networking/Client.hpp"
 #include "networking/Server.hpp"
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+// what SceneMatchGame::updateLoading() does next
+enum class MatchLoadingStage : uint8_t {
+    CONNECTING,   // client: waiting for the TCP connection
+    AWAITING_MAP, // client: waiting for the ServerAccept with the map and the spawns
+    PREPARING,    // worker: pixels, compiled map and the Map's layout
+    TILES,        // main thread: tiles and buildings, a few rows per frame
+    MESHES,       // worker: collision meshes
+    DONE,
+    FAILED
+};
 
 class SceneMatchGame {
 private:
@@ -39,30 +57,66 @@ int toggle_collision_mesh_crosshair = -1;
 
 Map* map = nullptr;
 std::string map_name = "";
+CompiledMap compiled_map; // only open while the match is being loaded
 std::pair<int, int> player_spawn = {};
 std::vector<std::pair<int, int>> spawn_positions = {};
-std::vector<std::vector<SDL_Color>> map_pixels_colors = {};
+std::shared_ptr<MapPixels> map_pixels_colors = nullptr; // shared with the simulation and its Map
+
+// --------------------------- LOADING ------------------------
+MatchLoadingStage loading_stage = MatchLoadingStage::DONE;
+std::thread loading_worker;
+std::atomic<bool> loading_worker_done = true;
+bool loading_worker_ok = false; // only read once loading_worker_done
+std::chrono::steady_clock::time_point loading_deadline;
+std::chrono::steady_clock::time_point loading_begin;
+const int CONNECT_TIMEOUT_S = 4;
+const int AWAIT_MAP_TIMEOUT_S = 10;
+const int LOADING_FRAME_BUDGET_MS = 8; // of main thread work per update while loading
+const uint32_t LOADING_TILE_ROWS = 4;  // rows created between checks of the budget
+// --------------------------- ------- ------------------------
 
 MapThumbnailComponent* minimap = nullptr;
+Visibility visibility;
+MatchSimulation simulation; // owns the map, this->map just points at it
 
 
 // --------------------------- NETWORKING ------------------------
 Client* client;
+std::vector<olc::net::owned_message<MessageTypes>> incoming = {}; // reused by processServerMessages()
 Server* server;
 bool is_server = false;
 bool is_client = false;
+bool lockstep_match = false; // only orders go through the network, see Lockstep.hpp
 std::unordered_map<uint32_t, int> clients_ping = {};
 std::unordered_map<uint32_t, MainColors> clients_color = {};
 MainColors PLAYER_COLOR = MainColors::NONE;
-bool update_server = false;
-const int PACKET_SIZE = 1300; // the ideal max size in bytes. 10 bytes or so over it is fine
-int64_t PING_MS; // this client's ping on the server
+const int LOCKSTEP_MAX_CATCH_UP_TICKS = 30; // extra ticks per tick when behind
+const int CLIENT_VIEW_RATE = 5; // ticks between checking if the server needs to know the camera moved
+int64_t PING_MS = 0; // this client's ping on the server
 uint32_t PLAYER_CLIENT_ID; // this client's ID on the server
-// drones which have been selected and have had their moveToPoint invoked on this Client. Their paths should then be sent to the server
-std::vector<Entity*> moved_drones = {};
-
-std::unordered_map<int, Vector2D> previous_drones_positions = {};
+uint32_t udp_token = 0;    // what this client's datagrams are signed with, from the ServerAccept
+
+DroneSnapshotReceiver snapshot_receiver;
+DroneInterpolationBuffer interpolation; // for the drones this client doesn't own
+
+// client-side prediction: this client's orders run locally right away, and get replayed on top of every snapshot until the
+// server says (ServerAck_Order) which snapshots already have them
+struct PredictedOrder {
+    uint32_t sequence;
+    uint64_t issued_tick; // this->simulation.tick when it was given
+    bool acked;
+    uint32_t acked_tick; // server tick it got applied on, every snapshot after it includes it
+    MoveOrder order;
+    // one per drone in order.net_ids, what the replays follow: the predicted path, then the server's once it's in
+    std::vector<std::vector<Vector2D>> paths;
+    std::vector<float> offcourse_limits;
+};
+std::deque<PredictedOrder> predicted_orders = {};
+uint32_t next_order_sequence = 1;
+const float PREDICTION_SNAP_DISTANCE = 64.0f; // further off than this and the drone jumps straight to the corrected position
+const float PREDICTION_CORRECTION = 0.2f;     // otherwise only this much of the error is fixed per snapshot
 std::vector<Vector2D> path_to_draw = {};
+std::vector<Vector2D> path_to_draw_screen = {};
 
 // --------------------------- ---------- ------------------------
 
@@ -81,173 +135,53 @@ SceneType change_to_scene = SceneType::NONE;
 TextComponent* fps_text;
 
 SceneMatchGame(SDL_Event* e) { this->event = e; }
-~SceneMatchGame() {
-    if(this->map) {
-        delete this->map;
-        this->map = nullptr;
-    }    
-}
-
-
-Entity& AddTileOnMap(int id, float width, int map_x, int map_y, std::vector<std::vector<int>>& layout, const std::vector<std::vector<SDL_Color>>& map_pixels = {}) {
-    auto& tile(Game::manager->addEntity("tile-"+std::to_string(map_x)+','+std::to_string(map_y)));
-    tile.reserveComponents(3);
-    const float world_x = map_x * width;
-    const float world_y = map_y * width;
-    
-    switch(id) {
-        case TILE_ROUGH:  {
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->rough_terrain_texture);
-        } break;
-        case TILE_IMPASSABLE: { 
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->mountain_texture);
-            uint8_t* neighbors = &tile.getComponent<RectangleCollider>().adjacent_rectangles;
-            SetSolidTileNeighbors(neighbors, map_x, map_y, layout);
-        } break;
-        case TILE_NAVIGABLE: { 
-            // need to be in this order to render the foreground "above" the background
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->water_bg_texture);
-            tile.addComponent<TileFGComponent>(world_x, world_y, width, width, id, this->water_fg_texture);
-        }
-        break;
-        case TILE_BASE_SPAWN: {
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture);
-            createBaseBuilding(
-                "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])), 
-                world_x, world_y, width, map_pixels[map_y][map_x]
-            );
-        } break;
-        case TILE_PLAYER: {
-            // whether it created a building or not, set as TILE_PLAIN regardless
-            layout[map_y][map_x] = tile_type::TILE_PLAIN;
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture);
-
-            Vector2D tile_xy = Vector2D(map_x, map_y);
-            Vector2D tile_center = Vector2D(world_x + width/2, world_y + width/2);
-            HexPos hex_tile = convertWorldToHex(tile_center);
-            std::cout << "TILE_PLAYER placed on hex tile {" << hex_tile.q << " , " << hex_tile.r << " }\n";
-            std::vector<Vector2D> hex_hull = getPointsFromHexPos(hex_tile);
-
-            Entity* created_building = nullptr;
-
-            if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
-                Vector2D hex_center = convertHexToWorld(hex_tile);
-                std::cout << "success on first pass: " << hex_center << '\n';
-                created_building = createBaseBuilding(
-                    "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])), 
-                    hex_center.x - HEX_SIDE_LENGTH, hex_center.y - HEX_SIDE_LENGTH, width, map_pixels[map_y][map_x]
-                );
-
-            } else {
-                std::cout << "else\n";
-                Vector2D hex_tile_pos = convertHexToWorld(hex_tile);
-                Vector2D neighbor_pos;
-                std::vector<HexPos> hex_neighbors = hexNeighbors(hex_tile, this->map->hex_grid_rect);
-                bool valid_spawn = false;
-                float free_pos_x, free_pos_y;
-                // first pass to prioritize spawn in same tile
-                for(HexPos& n : hex_neighbors) {
-                    neighbor_pos = convertHexToWorld(n);
-                    if(this->map->getTileCoordFromWorldPos(hex_tile_pos) == this->map->getTileCoordFromWorldPos(neighbor_pos)) {
-                        hex_hull = getPointsFromHexPos(n);
-                        if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
-                            valid_spawn = true;
-                            free_pos_x = neighbor_pos.x - HEX_SIDE_LENGTH;
-                            free_pos_y = neighbor_pos.y - HEX_SIDE_LENGTH;
-                            break;
-                        }                        
-                    }
-                }
-                // second pass to attempt any other free adjacent tile 
-                if(!valid_spawn) {
-                    for(HexPos& n : hex_neighbors) {
-                        neighbor_pos = convertHexToWorld(n);
-                        hex_hull = getPointsFromHexPos(n);
-                        if(this->map->hexFreeInMap(hex_hull, tile_xy)) {
-                            valid_spawn = true;
-                            free_pos_x = neighbor_pos.x - HEX_SIDE_LENGTH;
-                            free_pos_y = neighbor_pos.y - HEX_SIDE_LENGTH;
-                            break;
-                        }
-                    }
-                }
-                if(valid_spawn) {
-                    std::cout << "success on second pass: " << free_pos_x << ", " << free_pos_y << '\n';
-                    created_building = createBaseBuilding(
-                        "base_"+std::to_string((int)convertSDLColorToMainColor(map_pixels[map_y][map_x])), 
-                        free_pos_x, free_pos_y, width, map_pixels[map_y][map_x]
-                    );
-                } else {
-                    std::cout << "WARNING: can't create hex building from tile: " << tile_xy << '\n';
-                }
-            }
-        } break;
-        default: 
-            tile.addComponent<TileComponent>(world_x, world_y, width, width, id, this->plain_terrain_texture); 
-    }
-    
-    tile.addGroup(groupTiles);
-    return tile;
-}
-void LoadMapRender(float tile_scale=1.0f) {
-    uint64_t row, column;
-    SDL_Texture** tex = nullptr;
-    const float scaled_width = this->map->tile_width * tile_scale;
-    for(row = 0; row < this->map->layout_height; ++row) {
-        for(column = 0; column < this->map->layout_width; ++column) {
-            AddTileOnMap(
-                this->map->layout[row][column], 
-                scaled_width,
-                column, row,
-                this->map->layout,
-                this->map->map_pixels
-            );
-        }
-    }
-}
-
-void awaitMapData() {
-    bool got_data = false;
-    while(!got_data) {
-        if(!this->client->Incoming().empty()) {
-            auto msg = this->client->Incoming().pop_front().msg;
-            if(msg.header.id == MessageTypes::ServerAccept) {
-                std::string server_name;
-                msg >= server_name;
-                msg >> this->PLAYER_CLIENT_ID;
-                msg >= this->map_name;
-                const std::string file_path = "assets/maps/"+this->map_name+".bmp";
-                uint32_t map_width, map_height;
-                bool got_pixels = getBMPPixels(file_path, this->map_pixels_colors, &map_width, &map_height);
-                if(got_pixels) {
-                    msg >> this->PLAYER_COLOR;
-                    MainColors c;
-                    int first, second, players_amount;
-                    msg >> players_amount;
-                    for(int i=0; i<players_amount; ++i) {
-                        msg >> c;
-                        msg >> first;
-                        msg >> second;
-                        this->spawn_positions.push_back({ first, second });
-                        this->map_pixels_colors[first][second] = convertMainColorToSDL(c);
-                        if(c == this->PLAYER_COLOR) {
-                            this->player_spawn = { first, second };
-                        }
-                    }
-                    got_data = true;
-                } else {
-                    throw std::runtime_error("Failed to get map " + file_path + " form server.\n");
-                }
+~SceneMatchGame() { waitLoadingWorker(); }
+
+
+// non-blocking: true once the ServerAccept arrived, with this->map_name and the spawns read from it. Whatever comes before
+// it is dropped. The pixels are loaded (and the spawns painted) afterwards on the loading worker
+bool readMapData(std::vector<MainColors>& spawn_colors) {
+    olc::net::owned_message<MessageTypes> owned;
+    while(this->client->Incoming().try_pop(owned)) {
+        olc::net::message<MessageTypes>& msg = owned.msg;
+        if(msg.header.id != MessageTypes::ServerAccept) { continue; }
+        this->spawn_positions.clear();
+        std::string server_name;
+        msg >= server_name;
+        msg >> this->PLAYER_CLIENT_ID;
+        msg >= this->map_name;
+        msg >> this->PLAYER_COLOR;
+        MainColors c;
+        int first, second, players_amount;
+        msg >> players_amount;
+        for(int i=0; i<players_amount; ++i) {
+            msg >> c;
+            msg >> first;
+            msg >> second;
+            this->spawn_positions.push_back({ first, second });
+            spawn_colors.push_back(c);
+            if(c == this->PLAYER_COLOR) {
+                this->player_spawn = { first, second };
             }
         }
+        uint8_t lockstep_flag;
+        msg >> lockstep_flag;
+        this->lockstep_match = lockstep_flag != 0;
+        msg >> this->udp_token;
+        // spawn_positions received from the server come in the reverse order
+        std::reverse( this->spawn_positions.begin(), this->spawn_positions.end() );
+        std::reverse( spawn_colors.begin(), spawn_colors.end() );
+        return true;
     }
-    // spawn_positions received from the server come in the reverse order
-    std::reverse( this->spawn_positions.begin(), this->spawn_positions.end() );
+    return false;
 }
 
 void processServerMessages() {
-    while(!this->client->Incoming().empty()) {
-        auto msg = this->client->Incoming().pop_front().msg;
+    // everything the asio thread received since the last tick, in one go
+    this->incoming.clear();
+    this->client->Incoming().drain(this->incoming);
+    for(auto& owned : this->incoming) {
+        olc::net::message<MessageTypes>& msg = owned.msg;
         switch (msg.header.id) {
             case MessageTypes::ServerState_Colors: {
                 int clients_amount;
@@ -269,9 +203,36 @@ void processServerMessages() {
             case MessageTypes::ServerState_Drones: {
                 handleStateFromServer(msg);
             } break;
+            case MessageTypes::ServerState_Paths: {
+                handlePathsFromServer(msg);
+            } break;
+            case MessageTypes::ServerAck_Order: {
+                uint32_t sequence, tick;
+                olc::net::message_reader<MessageTypes> reader(msg);
+                reader.readVarint(sequence);
+                reader.read(tick);
+                if(!reader.ok()) { break; }
+                for(PredictedOrder& p : this->predicted_orders) {
+                    if(p.sequence == sequence) {
+                        p.acked = true;
+                        p.acked_tick = tick;
+                    }
+                }
+            } break;
+            case MessageTypes::ServerTurn_Orders: {
+                uint32_t turn;
+                std::vector<MoveOrder> orders;
+                if(LockstepMessages::readTurnMessage(msg, turn, orders)) {
+                    this->simulation.lockstep.addTurn(turn, std::move(orders));
+                } else {
+                    std::cout << "WARNING: malformed ServerTurn_Orders\n";
+                }
+            } break;
             case MessageTypes::ClientPing: {
                 // bounce back to calculate ping on server
                 this->client->Send(msg);
+                // and keep the UDP path open while at it
+                this->client->SendUdpHello(this->udp_token);
             } break;
             case MessageTypes::UsersStatus: {
                 int clients_amount;
@@ -291,19 +252,101 @@ void processServerMessages() {
                 }
             } break;
         }
+        olc::net::buffer_pool::instance().release(std::move(msg.body)); // for the next message the connection reads
     }
 }
 
+// runs `work` on loading_worker, there's only ever one running
+void startLoadingWorker(std::function<bool()> work) {
+    this->loading_worker_done = false;
+    this->loading_worker = std::thread([this, work = std::move(work)]() {
+        this->loading_worker_ok = work();
+        this->loading_worker_done = true;
+    });
+}
+// true (and joined) once the last work is finished
+bool loadingWorkerFinished() {
+    if(!this->loading_worker_done) { return false; }
+    if(this->loading_worker.joinable()) { this->loading_worker.join(); }
+    return true;
+}
+void waitLoadingWorker() {
+    if(this->loading_worker.joinable()) { this->loading_worker.join(); }
+    this->loading_worker_done = true;
+}
+
+void failLoading() {
+    waitLoadingWorker();
+    this->compiled_map.close();
+    this->loading_stage = MatchLoadingStage::FAILED;
+    this->change_to_scene = this->is_client ? SceneType::MULTIPLAYER_SELECTION : SceneType::MAIN_MENU;
+    Mix_PlayMusic(this->music_main_menu, -1);
+}
+
+// main thread, everything after the meshes
+void finishLoading() {
+    this->simulation.finishLoad();
+    this->map = this->simulation.map;
+    this->simulation.lockstep.enabled = this->lockstep_match;
+    Game::camera_diff = this->map->getWorldPosFromTileCoord(this->player_spawn.second, this->player_spawn.first) - Vector2D(Game::SCREEN_WIDTH>>1, Game::SCREEN_HEIGHT>>1);
+
+    // tiles and buildings don't move, their grids only need to be built once
+    this->visibility.setWorldBounds(this->map->world_layout_width, this->map->world_layout_height);
+    this->visibility.indexGroup(groupTiles,     4*this->map->tile_width, true);
+    this->visibility.indexGroup(groupBuildings, 4*this->map->tile_width, true);
+    this->visibility.indexGroup(groupDrones,    2*this->map->tile_width, false);
+
+    createUISimpleText("crosshair", 0, 0, "Crosshair: (-0000,-0000)");
+    createUISimpleText("camera_zoom", 0, 30, "Camera zoom: 0.0");
+
+    const float minimap_width = Game::SCREEN_WIDTH/5.0f;
+    const float minimap_height = Game::SCREEN_HEIGHT/5.0f;
+
+    this->minimap = new MapThumbnailComponent(
+        &this->buildings,
+        &this->drones,
+        *this->map_pixels_colors,
+        this->spawn_positions, 
+        Game::SCREEN_WIDTH - (minimap_width + 4), Game::SCREEN_HEIGHT - (minimap_height + 4), 
+        minimap_width, minimap_height
+    );
+    this->loading_stage = MatchLoadingStage::DONE;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Match Loading Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - this->loading_begin).count() << "[us]" << std::endl;
+}
+
+/**
+ * starts loading the match, updateLoading() does the rest over the next frames (Scene shows SceneLoading meanwhile)
+ * `map_pixels`, `player_color`, `player_spawn`, `spawn_positions`: from the match settings, a client gets them from the server instead
+ */
 void setScene(
     Mix_Music* music_main_menu,
     const std::string& map_name,
-    const std::vector<std::vector<SDL_Color>>& map_pixels, const SDL_Color& player_color, const std::pair<int,int>& player_spawn,
+    std::shared_ptr<MapPixels> map_pixels, const SDL_Color& player_color, const std::pair<int,int>& player_spawn,
     const std::vector<std::pair<int,int>>& spawn_positions,
     SDL_Texture* plain, SDL_Texture* rough, SDL_Texture* mountain, SDL_Texture* water_bg, SDL_Texture* water_fg, 
     TextComponent* fps
 ) {
     Mix_HaltMusic();
-    
+    this->music_main_menu = music_main_menu;
+    this->loading_begin = std::chrono::steady_clock::now();
+
+    Game::default_bg_color = COLORS_ROUGH;
+
+    this->plain_terrain_texture = plain;
+    this->rough_terrain_texture = rough;
+    this->mountain_texture = mountain;
+    this->water_bg_texture = water_bg;
+    this->water_fg_texture = water_fg;
+    this->fps_text = fps;
+
+    this->simulation.setTextures(
+        this->plain_terrain_texture,
+        this->rough_terrain_texture,
+        this->mountain_texture,
+        this->water_bg_texture,
+        this->water_fg_texture
+    );
 
     switch(Game::match_game_type) {
         case MatchGameType::SINGLE_PLAYER: {
@@ -311,96 +354,152 @@ void setScene(
             this->spawn_positions = spawn_positions;
             this->player_spawn = player_spawn;
             this->map_pixels_colors = map_pixels;
+            this->map_name = map_name;
             this->is_client = false;
             this->is_server = false;
+            this->lockstep_match = false;
         } break;
         case MatchGameType::MULTIPLAYER_CLIENT: {
             this->is_client = true;
             this->is_server = false;
             this->client = new Client();
-            bool connected = this->client->JoinGame(Game::REMOTE_HOST_IP);
-            if(!connected) {
-                this->change_to_scene = SceneType::MULTIPLAYER_SELECTION;
-                Mix_PlayMusic(music_main_menu, -1);
+            // the connection is made on the asio thread, updateLoading() waits for it
+            if(!this->client->Connect(Game::REMOTE_HOST_IP, 50000)) {
+                failLoading();
                 return;
             }
-            this->awaitMapData(); // TODO: refactor this function to have a timeout
+            this->loading_stage = MatchLoadingStage::CONNECTING;
+            this->loading_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(this->CONNECT_TIMEOUT_S);
+            return;
         } break;
         case MatchGameType::MULTIPLAYER_HOST: {
             this->PLAYER_COLOR = convertSDLColorToMainColor(player_color);
             this->spawn_positions = spawn_positions;
             this->player_spawn = player_spawn;
             this->map_pixels_colors = map_pixels;
+            this->map_name = map_name;
             this->is_client = false;
             this->is_server = true;
-            this->server = new Server(map_pixels, player_spawn, spawn_positions, map_name);
+            this->server = new Server(*map_pixels, player_spawn, spawn_positions, map_name);
+            this->lockstep_match = Game::LOCKSTEP;
+            if(this->lockstep_match) { this->server->EnableLockstep(); }
             this->server->Start();
         } break;
     }
 
-    Game::default_bg_color = COLORS_ROUGH;
-
-    this->plain_terrain_texture = plain;
-    this->rough_terrain_texture = rough;
-    this->mountain_texture = mountain;
-    this->water_bg_texture = water_bg;
-    this->water_fg_texture = water_fg;
-    this->fps_text = fps;
-
-    this->map = new Map(
-        this->map_pixels_colors, 
-        this->plain_terrain_texture,
-        this->rough_terrain_texture,
-        this->mountain_texture,
-        this->water_bg_texture,
-        this->water_fg_texture,
-        Game::DOUBLE_UNIT_SIZE
-    );
-
-    if(this->map->loaded) {
-        printf("Map  x: %d  by  y: %d\n", this->map->layout_width, this->map->layout_height);
-        const int tiles_amount = this->map->layout_width * this->map->layout_height;
-        Game::manager->reserveEntities(tiles_amount);
-        this->tiles.reserve(tiles_amount);
-        LoadMapRender();
-        Game::world_map_layout_width = this->map->world_layout_width;
-        Game::world_map_layout_height = this->map->world_layout_height;
-        Game::camera_diff = this->map->getWorldPosFromTileCoord(this->player_spawn.second, this->player_spawn.first) - Vector2D(Game::SCREEN_WIDTH>>1, Game::SCREEN_HEIGHT>>1);
-
-        this->map->generateCollisionMesh( 1, Game::collision_mesh_1,  Game::collision_mesh_1_width,  Game::collision_mesh_1_height,  this->buildings);
-        this->map->generateCollisionMesh( 4, Game::collision_mesh_4,  Game::collision_mesh_4_width,  Game::collision_mesh_4_height,  this->buildings);
-        this->map->generateCollisionMesh(16, Game::collision_mesh_16, Game::collision_mesh_16_width, Game::collision_mesh_16_height, this->buildings);
-        this->map->generateCollisionMesh(64, Game::collision_mesh_64, Game::collision_mesh_64_width, Game::collision_mesh_64_height, this->buildings);
-        this->map->generateCollisionMacroMesh( 4, Game::collision_mesh_macro_4,  Game::collision_mesh_macro_4_width,  Game::collision_mesh_macro_4_height);
-
-        for(const std::pair<int,int>& pos : this->spawn_positions) {
-            MainColors c = convertSDLColorToMainColor(this->map_pixels_colors[pos.first][pos.second]);
-            Vector2D world_pos = this->map->getWorldPosFromTileCoord(pos.second, pos.first-1);
-            createDrone(world_pos.x, world_pos.y, c);
-        }
-
-        createUISimpleText("crosshair", 0, 0, "Crosshair: (-0000,-0000)");
-        createUISimpleText("camera_zoom", 0, 30, "Camera zoom: 0.0");
+    this->loading_stage = MatchLoadingStage::PREPARING;
+    startLoadingWorker([this]() {
+        if(!this->compiled_map.isOpen()) { this->compiled_map.open("assets/maps/"+this->map_name); }
+        return this->simulation.prepareLoad(this->map_pixels_colors, this->spawn_positions, &this->compiled_map);
+    });
+}
 
-        const float minimap_width = Game::SCREEN_WIDTH/5.0f;
-        const float minimap_height = Game::SCREEN_HEIGHT/5.0f;
+// ---------------------------------- LOADING ----------------------------------
+// One stage per call, each frame, until loading_stage is DONE. Whatever only reads memory runs on loading_worker (decoding
+// the pixels, mapping the compiled map, classifying the tiles, building the collision meshes), whatever touches the ECS
+// or the renderer runs here on the main thread (tiles and buildings, a few rows per frame, then the drones and the minimap).
+// The host keeps serving its clients meanwhile. A client leaves everything after the ServerAccept queued until it's done
+void updateLoading() {
+    if(this->is_server) { this->server->Update(-1); }
+
+    switch(this->loading_stage) {
+        case MatchLoadingStage::CONNECTING: {
+            if(this->client->IsConnected()) {
+                this->loading_stage = MatchLoadingStage::AWAITING_MAP;
+                this->loading_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(this->AWAIT_MAP_TIMEOUT_S);
+            } else if(std::chrono::steady_clock::now() > this->loading_deadline) {
+                std::cout << "Could not connect to server (timed out).\n";
+                failLoading();
+            }
+        } break;
+        case MatchLoadingStage::AWAITING_MAP: {
+            std::vector<MainColors> spawn_colors;
+            if(readMapData(spawn_colors)) {
+                this->client->SendUdpHello(this->udp_token);
+                this->loading_stage = MatchLoadingStage::PREPARING;
+                startLoadingWorker([this, spawn_colors]() {
+                    const std::string file_path = "assets/maps/"+this->map_name;
+                    std::shared_ptr<MapPixels> pixels = std::make_shared<MapPixels>();
+                    if(!loadMapPixels(file_path, *pixels, this->compiled_map)) {
+                        std::cout << "Failed to get map " << file_path << " from server.\n";
+                        return false;
+                    }
+                    for(size_t i=0; i<this->spawn_positions.size(); ++i) {
+                        (*pixels)[this->spawn_positions[i].first][this->spawn_positions[i].second] = convertMainColorToSDL(spawn_colors[i]);
+                    }
+                    this->map_pixels_colors = pixels;
+                    return this->simulation.prepareLoad(this->map_pixels_colors, this->spawn_positions, &this->compiled_map);
+                });
+            } else if(!this->client->IsConnected() || std::chrono::steady_clock::now() > this->loading_deadline) {
+                std::cout << "The server didn't send the match (timed out).\n";
+                failLoading();
+            }
+        } break;
+        case MatchLoadingStage::PREPARING: {
+            if(!loadingWorkerFinished()) { break; }
+            if(!this->loading_worker_ok) {
+                printf("Map failed to load.\n");
+                failLoading();
+                break;
+            }
+            this->loading_stage = MatchLoadingStage::TILES;
+        } break;
+        case MatchLoadingStage::TILES: {
+            // as many rows as fit in the budget, so the window keeps getting frames
+            const std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now() + std::chrono::milliseconds(this->LOADING_FRAME_BUDGET_MS);
+            bool tiles_done = false;
+            while(!tiles_done && std::chrono::steady_clock::now() < stop) {
+                tiles_done = this->simulation.loadTileRows(this->LOADING_TILE_ROWS);
+            }
+            if(tiles_done) {
+                // nothing may add or destroy entities until it's finished, it reads the buildings
+                this->loading_stage = MatchLoadingStage::MESHES;
+                startLoadingWorker([this]() {
+                    this->simulation.loadCollisionMeshes();
+                    return true;
+                });
+            }
+        } break;
+        case MatchLoadingStage::MESHES: {
+            if(!loadingWorkerFinished()) { break; }
+            this->compiled_map.close();
+            finishLoading();
+        } break;
+        default: break;
+    }
+}
 
-        this->minimap = new MapThumbnailComponent(
-            &this->buildings,
-            &this->drones,
-            this->map_pixels_colors,
-            this->spawn_positions, 
-            Game::SCREEN_WIDTH - (minimap_width + 4), Game::SCREEN_HEIGHT - (minimap_height + 4), 
-            minimap_width, minimap_height
-        );
-    } else {
-        printf("Map failed to load.\n");
-        this->change_to_scene = SceneType::MAIN_MENU;
+float loadingProgress() const {
+    switch(this->loading_stage) {
+        case MatchLoadingStage::CONNECTING:   return 0.0f;
+        case MatchLoadingStage::AWAITING_MAP: return 0.05f;
+        case MatchLoadingStage::PREPARING:    return 0.1f;
+        case MatchLoadingStage::TILES:        return 0.2f + 0.6f*this->simulation.tilesProgress();
+        case MatchLoadingStage::MESHES:       return 0.8f;
+        default:                              return 1.0f;
     }
 }
 
+std::string loadingStatus() const {
+    switch(this->loading_stage) {
+        case MatchLoadingStage::CONNECTING:   return "Connecting to " + Game::REMOTE_HOST_IP;
+        case MatchLoadingStage::AWAITING_MAP: return "Waiting for the match";
+        case MatchLoadingStage::PREPARING:    return "Reading map";
+        case MatchLoadingStage::TILES:        return "Building tiles";
+        case MatchLoadingStage::MESHES:       return "Building collision meshes";
+        default:                              return "Starting";
+    }
+}
 
+bool loaded() const { return this->loading_stage == MatchLoadingStage::DONE; }
 
+// back to the menus, e.g. ESC on the loading screen
+void cancelLoading() {
+    if(this->loading_stage != MatchLoadingStage::DONE && this->loading_stage != MatchLoadingStage::FAILED) {
+        std::cout << "Match loading cancelled\n";
+        failLoading();
+    }
+}
 // --------------------------------- MOUSE ----------------------------------------
 void handleMouse(SDL_MouseButtonEvent& b) {
     Vector2D world_pos = convertScreenToWorld(Vector2D(b.x, b.y));
@@ -437,28 +536,60 @@ void handleMouse(SDL_MouseButtonEvent& b) {
         case SDL_BUTTON_RIGHT: {
             bool used_minimap; // maybe delete later, was using for debugging
             this->minimap->handleRightMouseDown(b.x, b.y, used_minimap, world_pos);
+            // shift for a quick order: jump point search, way cheaper on big open maps but it goes through rough terrain
+            // as if it was plain
+            const PathSearch search = (SDL_GetModState() & KMOD_SHIFT) ? PathSearch::JUMP_POINTS : PathSearch::A_STAR;
+            if(this->is_server || this->is_client) {
+                issueMoveOrder(world_pos, search);
+                break;
+            }
             DroneComponent* drone;
             for(auto& dr : this->drones) {
                 drone = &dr->getComponent<DroneComponent>();
                 if(drone->selected) {
-                    if(this->is_client) {
-                        // store path to send to server, but do not move drone
-                        drone->path = find_path(drone->getPosition(), world_pos, drone->offcourse_limit);
-                        drone->destination_position = world_pos;
-                        this->path_to_draw = drone->path;
-                        if(!this->path_to_draw.empty()) {
-                            this->moved_drones.push_back(dr);
-                            this->update_server = true;
-                        }                 
-                    } else {
-                        drone->moveToPoint(world_pos);
-                        this->path_to_draw = drone->path;
-                    }
+                    drone->path_search = search;
+                    drone->moveToPoint(world_pos);
+                    this->path_to_draw = drone->path;
                 }
             }  
         } break;
     }
 }
+// multiplayer: nothing moves right away. The order goes to the server, which sends back the paths (ServerState_Paths) or,
+// in lockstep, the turn every peer runs it on
+void issueMoveOrder(const Vector2D& world_pos, const PathSearch search) {
+    MoveOrder order;
+    order.destination = world_pos;
+    order.search = search;
+    for(auto& dr : this->drones) {
+        DroneComponent& drone = dr->getComponent<DroneComponent>();
+        if(drone.selected) { order.net_ids.push_back(drone.net_id); }
+    }
+    if(order.net_ids.empty()) { return; }
+    std::sort(order.net_ids.begin(), order.net_ids.end());
+    this->path_to_draw = {};
+    if(this->is_server) {
+        this->server->QueueOrder(std::move(order));
+    } else if(this->is_client) {
+        const uint32_t sequence = this->next_order_sequence++;
+        this->client->SendMoveOrder(sequence, order);
+        if(!this->lockstep_match) {
+            // don't wait a round trip, move now and let reconcileOwnDrones() fix it up as the snapshots come in
+            PredictedOrder predicted = { sequence, this->simulation.tick, false, 0, std::move(order) };
+            predicted.paths.reserve(predicted.order.net_ids.size());
+            predicted.offcourse_limits.reserve(predicted.order.net_ids.size());
+            for(const uint32_t& id : predicted.order.net_ids) {
+                DroneComponent& drone = Game::drones_by_net_id[id]->getComponent<DroneComponent>();
+                drone.path_search = search;
+                drone.moveToPoint(world_pos);
+                predicted.paths.push_back(drone.path);
+                predicted.offcourse_limits.push_back(drone.offcourse_limit);
+                this->path_to_draw = drone.path;
+            }
+            this->predicted_orders.push_back(std::move(predicted));
+        }
+    }
+}
 void handleMouseRelease(SDL_MouseButtonEvent& b) {
     if(b.button == SDL_BUTTON_MIDDLE) {
         this->draw_grids = !this->draw_grids;
@@ -469,91 +600,133 @@ void handleMouseRelease(SDL_MouseButtonEvent& b) {
 
 
 
-void sendStateToServer() {
-    if(this->moved_drones.size() > 0) {
-        DroneComponent* drone;
-        olc::net::message<MessageTypes> msg;
-        msg.header.id = MessageTypes::ClientState_Drones;
-        int drone_counter = 0;
-        int drone_path_size;
-        for(auto& dr : this->moved_drones) {
-            drone = &dr->getComponent<DroneComponent>();
-            drone_path_size = static_cast<int>(drone->path.size());
-            // send packet if the next drone would surpass 1300 B
-            if((static_cast<int>(msg.size()) + 14 + (8 * drone_path_size)) >= this->PACKET_SIZE) {
-                msg << drone_counter; // 4 B
-                this->client->Send(msg);
-                msg.body = {};
-                msg.header.size = msg.size();
-                drone_counter = 0;
+void handlePathsFromServer(olc::net::message<MessageTypes>& msg) {
+    // same layout as Server::ApplySolvedPaths() writes it
+    uint16_t drone_counter;
+    uint32_t drone_id, path_size;
+    float offcourse_limit;
+    uint16_t qx, qy;
+    std::vector<Vector2D> path;
+    olc::net::message_reader<MessageTypes> reader(msg);
+    reader.read(drone_counter);
+    for(int i=0; i<drone_counter; ++i) {
+        reader.readVarint(drone_id);
+        reader.read(offcourse_limit);
+        reader.readVarint(path_size);
+        if(!reader.ok() || path_size > reader.remaining() / 4) {
+            std::cout << "WARNING: malformed ServerState_Paths\n";
+            return;
+        }
+        path.resize(path_size);
+        for(uint32_t j=0; j<path_size; ++j) {
+            reader.read(qx);
+            reader.read(qy);
+            path[j] = Vector2D(
+                DroneSnapshots::dequantisePosition(qx, Game::world_map_layout_width),
+                DroneSnapshots::dequantisePosition(qy, Game::world_map_layout_height)
+            );
+        }
+        if(drone_id >= Game::drones_by_net_id.size()) { continue; }
+        DroneComponent& drone = Game::drones_by_net_id[drone_id]->getComponent<DroneComponent>();
+        // other players' drones follow the snapshots
+        if(drone.color_type != this->PLAYER_COLOR) { continue; }
+        // this client's own keep their predicted path while their newest order isn't acked (this path is for an older one).
+        // Once it is, the ack came before this (same tick, over TCP) and the server's path is the one the snapshots follow
+        PredictedOrder* newest = nullptr;
+        size_t index = 0;
+        for(PredictedOrder& p : this->predicted_orders) {
+            auto it = std::lower_bound(p.order.net_ids.begin(), p.order.net_ids.end(), drone.net_id);
+            if(it != p.order.net_ids.end() && *it == drone.net_id) {
+                newest = &p;
+                index = it - p.order.net_ids.begin();
             }
-            // send in reverse to ease load on server
-            for(int j=drone_path_size-1; j>=0; --j) {
-                msg << drone->path[j].y; // 4 B
-                msg << drone->path[j].x; // 4 B
-            } // subtotal: 8 ~ 1024 B (Most paths should be short, but it's technically unbounded)
-            msg << drone_path_size; // 4 B
-            msg << drone->offcourse_limit; // 4 B
-            msg <= dr->getIdentifier(); // 8 B
-            ++drone_counter;
         }
-        if(drone_counter > 0) { // for loop leftovers
-            msg << drone_counter;
-            this->client->Send(msg);
+        if(newest && !newest->acked) { continue; }
+        if(newest) {
+            newest->paths[index] = path;
+            newest->offcourse_limits[index] = offcourse_limit;
         }
-        this->moved_drones = {};
+        drone.moveToPointWithPath(path, offcourse_limit);
+        if(drone.selected) { this->path_to_draw = path; }
     }
 }
-void sendStateToClients() {
-    bool send_drones_state = true;
-    int current_drone_index = 0;
-    int drones_to_send = 0;
-    Entity* dr;
-    DroneComponent* drone_main;
-    TransformComponent* drone_transform;
-    // < 1 KB GOOD, 1200 B Okay, 1400 B Erm, 1500 B LIMIT
-    olc::net::message<MessageTypes> msg;
-    msg.header.id = MessageTypes::ServerState_Drones;
-    for(int i=0; i<this->drones.size(); ++i) {
-        if(static_cast<int>(msg.size()) + 26 >= this->PACKET_SIZE) {
-            msg << drones_to_send; // 4 B -> at most msg should have TOTAL: 1304 B
-            this->server->MessageAllClients(msg);
-            msg.body = {};
-            msg.header.size = msg.size();
-            drones_to_send = 0;
+void handleStateFromServer(olc::net::message<MessageTypes>& msg) {
+    // rebuild the snapshot against its baseline, then reconcile this client's drones with it and keep it to interpolate the rest
+    uint32_t sequence;
+    if(!this->snapshot_receiver.read(msg, Game::drones_by_net_id, sequence)) { return; }
+    this->client->AcknowledgeDronesState(sequence);
+    const DroneSnapshot* snapshot = this->snapshot_receiver.latest();
+    this->interpolation.push(*snapshot);
+    reconcileOwnDrones(*snapshot);
+}
+// one tick of a single drone without the rest of the world, only against what doesn't move
+void stepDroneAlone(DroneComponent& drone) {
+    const Vector2D previous_pos = drone.transform->position;
+    drone.preUpdate();
+    drone.transform->preUpdate();
+    drone.update();
+    drone.transform->update();
+    drone.handleStaticCollisions(previous_pos, this->tiles, this->buildings);
+    drone.handleCollisionTranslations(false); // no new searches while replaying, the real ticks still retrace
+    drone.handleOutOfBounds(Game::world_map_layout_width, Game::world_map_layout_height);
+}
+/**
+ * client-side prediction: put this client's drones where the server had them in `snapshot`, run them forward by half a
+ * round trip to get back to "now" replaying the orders the server hadn't applied yet (each on the tick it was given), then
+ * only correct part of the difference with the prediction so they don't visibly snap
+ */
+void reconcileOwnDrones(const DroneSnapshot& snapshot) {
+    // these are already part of the server state from here on
+    this->predicted_orders.erase(std::remove_if(this->predicted_orders.begin(), this->predicted_orders.end(), [&snapshot](const PredictedOrder& p) {
+        return p.acked && p.acked_tick < snapshot.tick;
+    }), this->predicted_orders.end());
+
+    const int latency_ticks = static_cast<int>((this->PING_MS / 2000.0f) * Game::TICK_RATE);
+    const size_t limit = std::min(snapshot.drones.size(), Game::drones_by_net_id.size());
+    for(size_t i=0; i<limit; ++i) {
+        DroneComponent& drone = Game::drones_by_net_id[i]->getComponent<DroneComponent>();
+        if(drone.color_type != this->PLAYER_COLOR) { continue; }
+        TransformComponent& t = *drone.transform;
+        const Vector2D predicted = t.position;
+        const Vector2D predicted_previous = t.previous_position;
+        DroneSnapshots::apply(snapshot.drones[i], t);
+
+        // newest order for this drone the snapshot doesn't have yet, and how many ticks into the replay it was given
+        const PredictedOrder* replay = nullptr;
+        size_t replay_index = 0;
+        for(const PredictedOrder& p : this->predicted_orders) {
+            auto it = std::lower_bound(p.order.net_ids.begin(), p.order.net_ids.end(), drone.net_id);
+            if(it != p.order.net_ids.end() && *it == drone.net_id) {
+                replay = &p;
+                replay_index = it - p.order.net_ids.begin();
+            }
         }
-        dr = this->drones[i];
-
-        // TODO: filter and only send data of "active" drones
-        drone_transform = &dr->getComponent<TransformComponent>();
-        msg << drone_transform->position.y;    // 4 B
-        msg << drone_transform->position.x;    // 4 B
-        msg << drone_transform->velocity.y;    // 4 B
-        msg << drone_transform->velocity.x;    // 4 B
-        msg <= dr->getIdentifier();            // 8 B
-                                        // TOTAL: 24 B
-        ++drones_to_send;
-    }
-    if(drones_to_send > 0) { // for loop leftovers
-        msg << drones_to_send;
-        this->server->MessageAllClients(msg);
+        const int replay_at = replay ? std::max(0, latency_ticks - static_cast<int>(this->simulation.tick - replay->issued_tick)) : -1;
+        for(int k=0; k<=latency_ticks; ++k) {
+            // the path it already has, searching again on every snapshot is what the path workers took off the main thread
+            if(k == replay_at) { drone.moveToPointWithPath(replay->paths[replay_index], replay->offcourse_limits[replay_index]); }
+            if(k == latency_ticks || (drone.path.empty() && k >= replay_at)) { break; } // standing still, nothing left to replay
+            stepDroneAlone(drone);
+        }
+
+        const Vector2D corrected = t.position;
+        if(Distance(predicted, corrected) < this->PREDICTION_SNAP_DISTANCE * this->PREDICTION_SNAP_DISTANCE) {
+            t.position = predicted + ((corrected - predicted) * this->PREDICTION_CORRECTION);
+        }
+        t.previous_position = predicted_previous;
     }
 }
-void handleStateFromServer(olc::net::message<MessageTypes>& msg) {
-    // get all new states and overwrite local state when needed
-    int drones_to_update;
-    std::string current_identifier;
-    Entity* drone;
-    TransformComponent* drone_transf;
-    msg >> drones_to_update;
-    for(int i=0; i<drones_to_update; ++i) {
-        msg >= current_identifier;
-        drone = Game::manager->getEntityFromGroup(current_identifier, groupDrones);
-        drone_transf = &drone->getComponent<TransformComponent>();
-        msg >> drone_transf->velocity.x;
-        msg >> drone_transf->velocity.y;
-        msg >> drone_transf->position.x;
-        msg >> drone_transf->position.y;
+// everything this client doesn't own is drawn from the snapshots, slightly in the past
+void interpolateRemoteDrones() {
+    this->interpolation.advance();
+    Vector2D position, velocity;
+    for(size_t i=0; i<Game::drones_by_net_id.size(); ++i) {
+        DroneComponent& drone = Game::drones_by_net_id[i]->getComponent<DroneComponent>();
+        if(drone.color_type == this->PLAYER_COLOR) { continue; }
+        if(this->interpolation.sample(i, position, velocity)) {
+            drone.transform->position = position;
+            drone.transform->velocity = velocity;
+        }
     }
 }
 void destroyServer() {
@@ -585,7 +758,6 @@ void destroyClient() {
 
 void handleEventsPrePoll() {
     // for multiplayer
-    this->moved_drones = {};
     if(this->is_server) {
         this->server->Update(-1);
     } else if(this->is_client && this->client->IsConnected()) {
@@ -661,48 +833,49 @@ void handleEventsPostPoll(const uint8_t *keystates) {
 
         if(!keystates[SDL_SCANCODE_W] && !keystates[SDL_SCANCODE_S]) { Game::camera_velocity.y = 0.0f; }
         if(!keystates[SDL_SCANCODE_A] && !keystates[SDL_SCANCODE_D]) { Game::camera_velocity.x = 0.0f; }
+
+        // the camera isn't part of the simulation, move it every frame with the real frame time
+        Game::camera_diff = Game::camera_diff + (Game::camera_velocity * Game::DEFAULT_SPEED * Game::FRAME_DELTA);
         
         if(keystates[SDL_SCANCODE_SPACE]) {
-            std::cout << "map{x , y}: " << this->map->layout.size() << ',' << this->map->layout[0].size() << "tile_width: " << this->map->tile_width << '\n';
+            std::cout << "map{x , y}: " << this->map->layout.size() << ',' << this->map->layout.width << "tile_width: " << this->map->tile_width << '\n';
         }
     }
 
-    if(this->is_client) {
-        if(this->update_server) {
-            sendStateToServer();
-            this->update_server = false;
-        }
-
-    } else if(this->is_server) {
-        if(Game::FRAME_COUNT % Game::CLIENT_PING_RATE == 0) { // once every 3 s
-            this->server->PingAllClients();
-        }
-
-        if(Game::FRAME_COUNT % Game::SERVER_STATE_SHARE_RATE == 0) { // once every 3 frames
-            sendStateToClients();
-        }     
-    }
 }
 
 
 
 
 void update() {
-    for(int i=0; i<this->drones.size(); ++i) {
-        this->previous_drones_positions[i] = this->drones[i]->getComponent<TransformComponent>().position;
+    if(this->is_server) {
+        if(this->lockstep_match) {
+            this->server->SealTurn(this->simulation.tick, this->simulation.lockstep);
+        } else {
+            this->server->ApplySolvedPaths(static_cast<uint32_t>(this->simulation.tick));
+        }
+    }
+    this->simulation.step();
+    if(this->is_client && this->lockstep_match) {
+        // behind the server (slow frames, or just joined and replaying the match so far), run a few extra ticks to catch up
+        for(int i=0; i<this->LOCKSTEP_MAX_CATCH_UP_TICKS && this->simulation.lockstep.turnsBuffered(this->simulation.tick) > Lockstep::INPUT_DELAY_TURNS; ++i) {
+            this->simulation.step();
+        }
+    } else if(this->is_client) {
+        interpolateRemoteDrones();
+        if(Game::TICK_COUNT % this->CLIENT_VIEW_RATE == 0) {
+            this->client->SendView(this->visibility.camera_rect);
+        }
     }
 
-    Game::manager->refresh();
-    Game::manager->preUpdate();
-    Game::manager->update();
-
-    // special case for camera
-    Game::camera_diff = Game::camera_diff + (Game::camera_velocity * Game::DEFAULT_SPEED * Game::FRAME_DELTA);
-
-    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleStaticCollisions(this->previous_drones_positions[i], this->tiles, this->buildings); }
-    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleDynamicCollisions(this->drones); }
-    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleCollisionTranslations(); }
-    for(int i=0; i<this->drones.size(); ++i) { this->drones[i]->getComponent<DroneComponent>().handleOutOfBounds(Game::world_map_layout_width, Game::world_map_layout_height); }
+    if(this->is_server) {
+        if(Game::TICK_COUNT % Game::CLIENT_PING_RATE == 0) { // once every 3 s
+            this->server->PingAllClients();
+        }
+        if(!this->lockstep_match && Game::TICK_COUNT % Game::SERVER_STATE_SHARE_RATE == 0) {
+            this->server->BroadcastDronesState(static_cast<uint32_t>(this->simulation.tick));
+        }
+    }
 
     Entity* e_crosshair = Game::manager->getEntityFromGroup("crosshair", groupUI);
     if(e_crosshair != nullptr) {
@@ -720,23 +893,26 @@ void update() {
     this->minimap->update();
 }
 void render() {
-    for(auto& t : this->tiles) { t->draw(); }
-    for(auto& b : this->buildings) { b->draw(); }
-    for(auto& dr : this->drones) { dr->draw(); }
+    this->visibility.refresh();
+    for(auto& t : this->visibility.getVisible(groupTiles)) { t->draw(); }
+    for(auto& b : this->visibility.getVisible(groupBuildings)) { b->draw(); }
+    for(auto& dr : this->visibility.getVisible(groupDrones)) { dr->draw(); }
     for(auto& bg_ui : this->bg_ui_elements) { bg_ui->draw(); }
     for(auto& ui : this->ui_elements) { ui->draw(); }
     for(auto& pr_ui : this->pr_ui_elements) { pr_ui->draw(); }
 
     // draw the path trajectory for debugging
     if(this->path_to_draw.size() > 0) {
-        int limit = this->path_to_draw.size()-1;
+        this->path_to_draw_screen.resize(this->path_to_draw.size());
+        Camera::worldToScreen(this->path_to_draw.data(), this->path_to_draw_screen.data(), this->path_to_draw.size());
+        int limit = this->path_to_draw_screen.size()-1;
         for(int i=0; i<limit; ++i) {
             TextureManager::DrawLine(
-                convertWorldToScreen(this->path_to_draw[i]), 
-                convertWorldToScreen(this->path_to_draw[i+1]), 
+                this->path_to_draw_screen[i], 
+                this->path_to_draw_screen[i+1], 
                 COLORS_RED
             );
-            Vector2D p_pos = convertWorldToScreen(this->path_to_draw[i]);
+            const Vector2D& p_pos = this->path_to_draw_screen[i];
             SDL_FRect path_point = { p_pos.x - 2.0f, p_pos.y - 2.0f, 4.0f, 4.0f };
             TextureManager::DrawRect(&path_point, COLORS_CYAN);
         }
@@ -749,15 +925,24 @@ void render() {
         int max_r_axis = (this->map->layout_height<<1) / 1.5f;
         int min_q_axis = -(max_q_axis>>1);
 
+        // only walk the hexes under the camera: rows come from y = 1.5*r, then each row's q from its x span
+        const SDL_FRect& cam = this->visibility.camera_rect;
+        const float hex_margin = HEX_SIDE_LENGTH;
+        const int first_r = std::max(0,          static_cast<int>(std::floor((cam.y - hex_margin) / one_and_half_HEX_SIDE_LENGTH)));
+        const int last_r  = std::min(max_r_axis, static_cast<int>(std::ceil((cam.y + cam.h + hex_margin) / one_and_half_HEX_SIDE_LENGTH)));
+
         HexPos current_hex = { 0, 0 };
         Vector2D hex_pos, hex_world_pos;
         float hex_pos_w = 4.0f;
         SDL_Color hex_border_color = { 0x00, 0xF0, 0x20, SDL_ALPHA_OPAQUE };
         SDL_FRect hex_center = { hex_pos.x, hex_pos.y, hex_pos_w, hex_pos_w };
-        for(int q=min_q_axis; q<=max_q_axis; ++q) {
-            current_hex.q = q;
-            for(int r=0; r<=max_r_axis; ++r) {
-                current_hex.r = r;
+        for(int r=first_r; r<=last_r; ++r) {
+            current_hex.r = r;
+            const float row_shift = half_sqrt_3 * r;
+            const int first_q = std::max(min_q_axis, static_cast<int>(std::floor(((cam.x - hex_margin) / HEX_SIDE_LENGTH - row_shift) / sqrt_3)));
+            const int last_q  = std::min(max_q_axis, static_cast<int>(std::ceil(((cam.x + cam.w + hex_margin) / HEX_SIDE_LENGTH - row_shift) / sqrt_3)));
+            for(int q=first_q; q<=last_q; ++q) {
+                current_hex.q = q;
                 hex_world_pos = convertHexToWorld(current_hex);
 
                 if(Collision::pointInRect(
@@ -774,7 +959,7 @@ void render() {
                     float offset_x = hex_world_pos.x - HEX_SIDE_LENGTH;
                     float offset_y = hex_world_pos.y - HEX_SIDE_LENGTH;
 
-                    std::vector<Vector2D> hex_hull = { 
+                    const Vector2D hex_hull[6] = { 
                         {         right_x + offset_x,      greater_height + offset_y },
                         { HEX_SIDE_LENGTH + offset_x, HEX_RECT_TILE_WIDTH + offset_y },
                         {           x_gap + offset_x,      greater_height + offset_y },
@@ -784,15 +969,10 @@ void render() {
                     };
 
                     SDL_FPoint draw_points[7];
-                    SDL_FPoint p;
-                    for(int i=0; i<6; ++i) {
-                        Vector2D s_p = convertWorldToScreen(hex_hull[i]);
-                        p.x = s_p.x; p.y = s_p.y;
-                        draw_points[i] = p;
-                    }
+                    Camera::worldToScreen(hex_hull, draw_points, 6);
                     draw_points[6] = draw_points[0];                                
 
-                    hex_pos = convertWorldToScreen(hex_world_pos);
+                    hex_pos = Camera::worldToScreen(hex_world_pos);
                     hex_center.x = hex_pos.x - 2.0f;
                     hex_center.y = hex_pos.y - 2.0f;
 
@@ -816,10 +996,10 @@ void render() {
         SDL_FRect grid_line;
         pivot.y = 0.0f;
         grid_line.w = 1.0f;
-        grid_line.h = this->map->world_layout_height * Game::camera_zoom;
+        grid_line.h = this->map->world_layout_height * Camera::scale;
         for(int i=0; i<=this->map->layout_width; ++i) {
             pivot.x = i*(this->map->tile_width);
-            Vector2D pos = convertWorldToScreen(Vector2D(pivot.x, pivot.y));
+            Vector2D pos = Camera::worldToScreen(pivot);
             grid_line.x = pos.x;
             grid_line.y = pos.y;
             if(
@@ -832,11 +1012,11 @@ void render() {
             }
         }
         pivot.x = 0.0f;
-        grid_line.w = this->map->world_layout_width * Game::camera_zoom;
+        grid_line.w = this->map->world_layout_width * Camera::scale;
         grid_line.h = 1.0f;
         for(int i=0; i<=this->map->layout_height; ++i) {
             pivot.y = i*(this->map->tile_width);
-            Vector2D pos = convertWorldToScreen(Vector2D(pivot.x, pivot.y));
+            Vector2D pos = Camera::worldToScreen(pivot);
             grid_line.x = pos.x;
             grid_line.y = pos.y;
             if(
@@ -901,9 +1081,9 @@ void render() {
                     case 1:
                     case 2:
                     case 3:
-                        p_center = convertWorldToScreen( convertMeshNodeToVector2D({x, y}, mesh_density) ); break;
+                        p_center = Camera::worldToScreen( convertMeshNodeToVector2D({x, y}, mesh_density) ); break;
                     case 4:
-                        p_center = convertWorldToScreen( convertMacroMeshNodeToVector2D({x, y}, mesh_density) ); break;
+                        p_center = Camera::worldToScreen( convertMacroMeshNodeToVector2D({x, y}, mesh_density) ); break;
                 }
                 if(!Collision::pointInRect(p_center.x, p_center.y, 0.0f, 0.0f, Game::SCREEN_WIDTH, Game::SCREEN_HEIGHT)) {
                     continue;
@@ -942,18 +1122,27 @@ void render() {
     this->minimap->draw();
 }
 void clean() {
+    waitLoadingWorker(); // e.g. the window was closed while loading
+    this->compiled_map.close();
+    this->loading_stage = MatchLoadingStage::DONE;
     if(this->minimap) { delete this->minimap; this->minimap = nullptr; }
     if(this->is_server) { destroyServer(); }
     if(this->is_client) { destroyClient(); }
     this->map = nullptr;
+    this->simulation.clean();
     this->PLAYER_COLOR = MainColors::NONE;
     this->clients_ping = {};
     this->clients_color = {};
-    this->moved_drones = {};
-    this->previous_drones_positions = {};
+    this->path_to_draw = {};
+    this->path_to_draw_screen = {};
+    this->snapshot_receiver.reset();
+    this->interpolation.reset();
+    this->predicted_orders.clear();
+    this->next_order_sequence = 1;
+    this->lockstep_match = false;
     this->PING_MS = 0;
     this->PLAYER_CLIENT_ID = -1;
-    this->update_server = false;
+    this->visibility.clear();
     Game::manager->clearEntities();
 }
 };
\ No newline at end of file
@@ -38,7 +38,7 @@ SceneType change_to_scene = SceneType::NONE;
 std::vector<std::pair<int,int>> spawn_positions = {};
 int player_spawn_index = -1;
 SDL_Color player_sdl_color = COLORS_SPAWN;
-std::vector<std::vector<SDL_Color>> map_pixels = {};
+std::shared_ptr<MapPixels> map_pixels = nullptr; // handed over to the match as is
 
 SceneMatchSettings(SDL_Event* e) { this->event = e; }
 ~SceneMatchSettings() {}
@@ -56,12 +56,12 @@ void setScene(Mix_Chunk*& sound_b, TextComponent* fps, SceneType parent, const s
         Game::default_text_color, COLORS_UI_BUTTON_BACKGROUND_1, COLORS_UI_BUTTON_BORDER_1,
         [this](TextBoxComponent& self) {
             Mix_PlayChannel(-1, this->sound_button, 0);
-            this->map_pixels = this->selected_map->getComponent<MapThumbnailComponent>().map_pixels;
+            this->map_pixels = std::make_shared<MapPixels>(this->selected_map->getComponent<MapThumbnailComponent>().map_pixels);
 
             std::vector<MainColors> used_colors = {};
             // first pass to get those with colors selected
             for(std::pair<int,int>& pos : this->spawn_positions) {
-                SDL_Color c = this->map_pixels[pos.first][pos.second];
+                SDL_Color c = (*this->map_pixels)[pos.first][pos.second];
                 if(!isSameColor(c, COLORS_SPAWN)) {
                     used_colors.push_back(convertSDLColorToMainColor(c));
                 }
@@ -75,14 +75,14 @@ void setScene(Mix_Chunk*& sound_b, TextComponent* fps, SceneType parent, const s
             }
             // second pass to set those with COLORS_SPAWN
             for(std::pair<int,int>& pos : this->spawn_positions) {
-                if(isSameColor(this->map_pixels[pos.first][pos.second], COLORS_SPAWN)) {
+                if(isSameColor((*this->map_pixels)[pos.first][pos.second], COLORS_SPAWN)) {
                     MainColors random_color = randomFromVector(Game::RNG, possible_colors);
                     possible_colors.erase( std::find(possible_colors.begin(), possible_colors.end(), random_color) );
-                    this->map_pixels[pos.first][pos.second] = convertMainColorToSDL(random_color);
+                    (*this->map_pixels)[pos.first][pos.second] = convertMainColorToSDL(random_color);
                 }
             }
 
-            this->player_sdl_color = this->map_pixels[
+            this->player_sdl_color = (*this->map_pixels)[
                 this->spawn_positions[ this->player_spawn_index ].first
             ][
                 this->spawn_positions[ this->player_spawn_index ].second
@@ -112,7 +112,7 @@ void setScene(Mix_Chunk*& sound_b, TextComponent* fps, SceneType parent, const s
     );
     
     MapThumbnailComponent& thumbnail = this->selected_map->getComponent<MapThumbnailComponent>();
-    std::vector<std::vector<SDL_Color>>& map_pixels = thumbnail.map_pixels;
+    MapPixels& map_pixels = thumbnail.map_pixels;
     uint32_t map_width = thumbnail.map_width;
     uint32_t map_height = thumbnail.map_height;
     int width_max_digits = std::to_string(map_width).size();
@@ -188,7 +188,7 @@ bool isValidPlayerSpawn() {
 
 bool isValidMapSpawns() {
     MapThumbnailComponent& map_thumbnail = this->selected_map->getComponent<MapThumbnailComponent>();
-    std::vector<std::vector<SDL_Color>>& map_pixels = map_thumbnail.map_pixels;
+    MapPixels& map_pixels = map_thumbnail.map_pixels;
     std::vector<SDL_Color> colors_found = {};
     
     for(uint32_t y=0; y<map_thumbnail.map_height; ++y) {
@@ -263,8 +263,8 @@ void handleMouseRelease(SDL_MouseButtonEvent& b) {
                             [this](TextBoxComponent& self) {
                                 self.mouse_down = false;
                                 Mix_PlayChannel(-1, this->sound_button, 0);
-                                this->map_pixels = this->selected_map->getComponent<MapThumbnailComponent>().map_pixels;
-                                this->player_sdl_color = this->map_pixels[
+                                this->map_pixels = std::make_shared<MapPixels>(this->selected_map->getComponent<MapThumbnailComponent>().map_pixels);
+                                this->player_sdl_color = (*this->map_pixels)[
                                     this->spawn_positions[ this->player_spawn_index ].first
                                 ][
                                     this->spawn_positions[ this->player_spawn_index ].second
@@ -4,6 +4,7 @@
 #include "Game.hpp"
 #include "Vector2D.hpp"
 #include "AudioManager.hpp"
+#include "AssetManager.hpp"
 #include "SceneTypes.hpp"
 #include "Scene_utils.hpp"
 #include "json.hpp"
@@ -163,11 +164,8 @@ void changeScreenResolution(unsigned int width, unsigned int height) {
     o << this->config_json.dump(4);
     o.close();
     Mix_PlayChannel(-1, this->sound_button, 0);
-    // soft destroy
-    SDL_DestroyTexture(Game::unit_tex);
-    SDL_DestroyTexture(Game::building_tex);
-    Game::unit_tex = nullptr;
-    Game::building_tex = nullptr;
+    // textures belong to the renderer that made them. This scene holds none, so this frees every cached one before it goes
+    AssetManager::releaseUnused();
 
     SDL_DestroyWindow(Game::window);
     SDL_DestroyRenderer(Game::renderer);
@@ -182,11 +180,9 @@ void changeScreenResolution(unsigned int width, unsigned int height) {
 
 void changeFPS(unsigned int new_fps) {
     Mix_PlayChannel(-1, this->sound_button, 0);
-    int previous_broadcast_rate = (1/static_cast<float>(Game::SERVER_STATE_SHARE_RATE)) * Game::MAX_FPS;
+    // network rates are counted in simulation ticks, so they don't care about the frame rate
     Game::MAX_FPS = new_fps;
     Game::MAX_FRAME_DELAY = 1000.0f / new_fps;
-    Game::SERVER_STATE_SHARE_RATE = new_fps / previous_broadcast_rate;
-    Game::CLIENT_PING_RATE = new_fps * 3;
 }
 
 void handleMouse(SDL_MouseButtonEvent& b) {
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <SDL2/SDL.h>
+#include "Game.hpp"
+#include "Vector2D.hpp"
+#include "ECS/ECS.hpp"
+#include "ECS/TransformComponent.hpp"
+
+// Uniform bucket grid over the world to answer "what is inside this rectangle?" without checking every entity.
+// Entities are bucketed by the center of their TransformComponent, so queries get expanded by the biggest half extent seen.
+// Everything is stored flat (counting sort into a single array), so rebuilding it every frame doesn't allocate once it has grown.
+class SpatialGrid {
+private:
+    float cell_size = 256.0f;
+    float inv_cell_size = 1.0f / 256.0f;
+    int columns = 0;
+    int rows = 0;
+    float max_half_extent = 0.0f;
+
+    std::vector<int> cell_start = {}; // offsets into entries, cell i goes from cell_start[i] to cell_start[i+1]
+    std::vector<Entity*> entries = {};
+    std::vector<int> entity_cell = {}; // scratch for build()
+
+    int cellX(float x) const { return std::clamp(static_cast<int>(std::floor(x * this->inv_cell_size)), 0, this->columns-1); }
+    int cellY(float y) const { return std::clamp(static_cast<int>(std::floor(y * this->inv_cell_size)), 0, this->rows-1); }
+
+public:
+    SpatialGrid() {}
+
+    void setBounds(float world_width, float world_height, float size) {
+        this->cell_size = size;
+        this->inv_cell_size = 1.0f / size;
+        this->columns = std::max(1, static_cast<int>(std::ceil(world_width  * this->inv_cell_size)));
+        this->rows    = std::max(1, static_cast<int>(std::ceil(world_height * this->inv_cell_size)));
+        this->cell_start.assign(this->columns * this->rows + 1, 0);
+        this->entries.clear();
+    }
+
+    void clear() {
+        std::fill(this->cell_start.begin(), this->cell_start.end(), 0);
+        this->entries.clear();
+        this->max_half_extent = 0.0f;
+    }
+
+    // rebuild the whole grid from a group of entities (all of them must have a TransformComponent)
+    void build(const std::vector<Entity*>& entities) {
+        if(this->columns == 0) { return; }
+        const int cells_amount = this->columns * this->rows;
+        this->entity_cell.resize(entities.size());
+        std::fill(this->cell_start.begin(), this->cell_start.end(), 0);
+        this->max_half_extent = 0.0f;
+
+        // count
+        for(size_t i=0; i<entities.size(); ++i) {
+            TransformComponent& t = entities[i]->getComponent<TransformComponent>();
+            const float half_w = t.width  * t.scale * 0.5f;
+            const float half_h = t.height * t.scale * 0.5f;
+            this->max_half_extent = std::max(this->max_half_extent, std::max(half_w, half_h));
+            const int cell = cellY(t.position.y + half_h) * this->columns + cellX(t.position.x + half_w);
+            this->entity_cell[i] = cell;
+            ++this->cell_start[cell+1];
+        }
+        // prefix sum
+        for(int c=0; c<cells_amount; ++c) {
+            this->cell_start[c+1] += this->cell_start[c];
+        }
+        // scatter, keeping the group order inside each cell
+        this->entries.resize(entities.size());
+        for(size_t i=0; i<entities.size(); ++i) {
+            this->entries[this->cell_start[this->entity_cell[i]]++] = entities[i];
+        }
+        // scattering moved every start to the next cell's start, shift them back
+        for(int c=cells_amount; c>0; --c) {
+            this->cell_start[c] = this->cell_start[c-1];
+        }
+        this->cell_start[0] = 0;
+    }
+
+    // append to out every entity whose center could make it overlap rect (world coordinates)
+    void query(const SDL_FRect& rect, std::vector<Entity*>& out, float padding=0.0f) const {
+        if(this->columns == 0 || this->entries.empty()) { return; }
+        const float expand = this->max_half_extent + padding;
+        const int min_x = cellX(rect.x - expand);
+        const int max_x = cellX(rect.x + rect.w + expand);
+        const int min_y = cellY(rect.y - expand);
+        const int max_y = cellY(rect.y + rect.h + expand);
+        for(int y=min_y; y<=max_y; ++y) {
+            const int row_offset = y * this->columns;
+            for(int x=min_x; x<=max_x; ++x) {
+                const int begin = this->cell_start[row_offset + x];
+                const int end = this->cell_start[row_offset + x + 1];
+                for(int i=begin; i<end; ++i) {
+                    out.push_back(this->entries[i]);
+                }
+            }
+        }
+    }
+
+    // cell the point falls in (clamped to the grid), and that cell's rectangle in world coordinates
+    int cellOf(const Vector2D& p) const { return cellY(p.y) * this->columns + cellX(p.x); }
+    SDL_FRect cellRect(int cell) const {
+        return { (cell % this->columns) * this->cell_size, (cell / this->columns) * this->cell_size, this->cell_size, this->cell_size };
+    }
+
+    void queryRadius(const Vector2D& center, float radius, std::vector<Entity*>& out) const {
+        SDL_FRect rect = { center.x - radius, center.y - radius, radius*2, radius*2 };
+        query(rect, out);
+    }
+
+    size_t size() const { return this->entries.size(); }
+};
@@ -1,8 +1,14 @@
 #include "TextureManager.hpp"
+#ifndef HEADLESS
+#include "AssetManager.hpp"
+#endif
 
 // When in doubt: https://stackoverflow.com/questions/21007329/what-is-an-sdl-renderer
 
 SDL_Texture* TextureManager::LoadTexture(const char* texture_file_path) {
+#ifdef HEADLESS
+    return NULL;
+#else
     SDL_Surface* tempSurface = IMG_Load(texture_file_path);
     if(tempSurface == NULL) {
         SDL_Log("Unable to render surface. SDL_Image Error: %s\n", SDL_GetError());
@@ -15,17 +21,41 @@ SDL_Texture* TextureManager::LoadTexture(const char* texture_file_path) {
     }
     SDL_FreeSurface(tempSurface);
     return tex;
+#endif
+}
+
+// `pixels`: width*height RGBA pixels, top row first. Only read during the call
+SDL_Texture* TextureManager::LoadTextureFromPixels(const SDL_Color* pixels, int width, int height) {
+#ifdef HEADLESS
+    return NULL;
+#else
+    SDL_Surface* tempSurface = SDL_CreateRGBSurfaceWithFormatFrom(
+        const_cast<SDL_Color*>(pixels), width, height, 32, width * static_cast<int>(sizeof(SDL_Color)), SDL_PIXELFORMAT_RGBA32
+    );
+    if(tempSurface == NULL) {
+        SDL_Log("Unable to create surface from pixels. SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(Game::renderer, tempSurface);
+    SDL_FreeSurface(tempSurface);
+    if(tex == NULL) {
+        SDL_Log("Unable to create texture. SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    return tex;
+#endif
 }
 
 SDL_Texture* TextureManager::LoadTextTexture(const char* text, const SDL_Color& color, int& output_w, int& output_h, const char* font_path) {
+#ifdef HEADLESS
+    return NULL;
+#else
     SDL_Surface* tempSurface;
     if(font_path == nullptr) {
         tempSurface = TTF_RenderUTF8_Solid(Game::default_font, text, color);
     } else {
-        TTF_Font *font = TTF_OpenFont(font_path, 28);
-        tempSurface = TTF_RenderUTF8_Solid(font, text, color);
-        TTF_CloseFont(font);
-        font = NULL;
+        AssetManager::FontHandle font = AssetManager::font(font_path, 28);
+        tempSurface = TTF_RenderUTF8_Solid(font.get(), text, color);
     }
 
     if(tempSurface == NULL) {
@@ -42,6 +72,7 @@ SDL_Texture* TextureManager::LoadTextTexture(const char* text, const SDL_Color&
     output_h = tempSurface->h;
     SDL_FreeSurface(tempSurface);
     return tex;
+#endif
 }
 
 void setRenderDrawColor(const SDL_Color& color) {
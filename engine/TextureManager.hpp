@@ -6,6 +6,7 @@
 class TextureManager {
     public:
         static SDL_Texture* LoadTexture(const char* texture_file_path);
+        static SDL_Texture* LoadTextureFromPixels(const SDL_Color* pixels, int width, int height);
         static SDL_Texture* LoadTextTexture(const char* text, const SDL_Color& color,  int& output_w, int& output_h, const char* font_path=nullptr);
         static void Draw(SDL_Texture* tex, SDL_Rect *src, SDL_FRect *dest, double rotation_degrees=0, SDL_RendererFlip flip=SDL_FLIP_NONE, const SDL_Color& color={ 0xFF, 0xFF, 0xFF });
         static void DrawSimpleText(const SDL_Color& color, SDL_Texture* tex, SDL_Rect *src, SDL_FRect *dest, double rotation_degrees=0, SDL_RendererFlip flip=SDL_FLIP_NONE);
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include "utils.hpp"
+#include "CompiledMap.hpp"
+
+struct ThumbnailRequest {
+    uint32_t index;      // whatever the caller uses to find the thumbnail again
+    uint32_t generation; // results of an older generation are for thumbnails that don't exist anymore
+    std::string map_dir;
+    std::string map_name;
+    uint32_t side;       // size it's drawn at, bigger maps are scaled down to it
+};
+
+struct ThumbnailResult {
+    uint32_t index;
+    uint32_t generation;
+    bool loaded = false;
+    uint32_t map_width = 0;
+    uint32_t map_height = 0;
+    MapPixels pixels = {}; // at most side x side
+};
+
+// One thread that turns map BMPs into small thumbnails so the map selection opens without reading a single map.
+// Thumbnails are cached in <map_dir>.cache/<map_name>.thumb next to the maps. A cache entry is used as is while the BMP's
+// mtime and size are the same, and if only the mtime changed it's still used when the BMP's hash is the same.
+// Textures can only be created on the main thread, so results come back as pixels through collect().
+class ThumbnailLoader {
+private:
+static constexpr uint32_t CACHE_MAGIC = 0x424d4854; // "THMB"
+static constexpr uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t source_mtime;
+    uint64_t source_size;
+    uint64_t source_hash;
+    uint32_t map_width, map_height;
+    uint32_t width, height; // of the thumbnail
+};
+
+std::thread worker;
+std::deque<ThumbnailRequest> requests = {};
+std::vector<ThumbnailResult> results = {};
+std::mutex requests_mutex;
+std::mutex results_mutex;
+std::condition_variable requests_cv;
+bool stopping = false;
+
+void work() {
+    ThumbnailRequest request;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(this->requests_mutex);
+            this->requests_cv.wait(lock, [this]() { return this->stopping || !this->requests.empty(); });
+            if(this->stopping) { return; }
+            request = std::move(this->requests.front());
+            this->requests.pop_front();
+        }
+        ThumbnailResult result;
+        result.index = request.index;
+        result.generation = request.generation;
+        result.loaded = loadThumbnail(request, result);
+        {
+            std::lock_guard<std::mutex> lock(this->results_mutex);
+            this->results.push_back(std::move(result));
+        }
+    }
+}
+
+static bool writeCache(const std::string& cache_path, const CacheHeader& header, const MapPixels& pixels) {
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::u8path(cache_path).parent_path(), ec);
+    const std::string temp_path = cache_path+".tmp";
+    {
+        std::ofstream out(std::filesystem::u8path(temp_path), std::ios::binary | std::ios::trunc);
+        if(!out) { return false; }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        out.write(reinterpret_cast<const char*>(pixels.data()), pixels.cells.size() * sizeof(SDL_Color));
+        if(!out) { return false; }
+    }
+    std::filesystem::rename(std::filesystem::u8path(temp_path), std::filesystem::u8path(cache_path), ec);
+    return !ec;
+}
+
+public:
+ThumbnailLoader() {
+    this->worker = std::thread([this]() { work(); });
+}
+~ThumbnailLoader() { stop(); }
+
+void submit(ThumbnailRequest request) {
+    {
+        std::lock_guard<std::mutex> lock(this->requests_mutex);
+        this->requests.push_back(std::move(request));
+    }
+    this->requests_cv.notify_one();
+}
+
+// moves every finished thumbnail into `out` (which is cleared first)
+void collect(std::vector<ThumbnailResult>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(this->results_mutex);
+    std::swap(out, this->results);
+}
+
+// drops everything queued or finished. The one being loaded still comes back, with its old generation
+void cancel() {
+    {
+        std::lock_guard<std::mutex> lock(this->requests_mutex);
+        this->requests.clear();
+    }
+    std::lock_guard<std::mutex> lock(this->results_mutex);
+    this->results.clear();
+}
+
+void stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->requests_mutex);
+        this->stopping = true;
+        this->requests.clear();
+    }
+    this->requests_cv.notify_all();
+    if(this->worker.joinable()) { this->worker.join(); }
+}
+
+// fills `result` from the cache, or from the BMP (and caches it). Runs on the worker thread
+static bool loadThumbnail(const ThumbnailRequest& request, ThumbnailResult& result) {
+    const std::string source_path = request.map_dir+request.map_name+".bmp";
+    const std::string cache_path = request.map_dir+".cache/"+request.map_name+".thumb";
+    std::error_code ec;
+    const std::filesystem::path source = std::filesystem::u8path(source_path);
+    const int64_t source_mtime = static_cast<int64_t>(std::filesystem::last_write_time(source, ec).time_since_epoch().count());
+    if(ec) { return false; }
+    const uint64_t source_size = static_cast<uint64_t>(std::filesystem::file_size(source, ec));
+    if(ec) { return false; }
+
+    CacheHeader header;
+    MappedFile cache;
+    if(cache.open(cache_path) && cache.size() >= sizeof(CacheHeader)) {
+        memcpy(&header, cache.data(), sizeof(CacheHeader));
+        const bool valid = header.magic == CACHE_MAGIC && header.version == CACHE_VERSION
+            && header.width  == std::min(header.map_width,  request.side) && header.width  > 0
+            && header.height == std::min(header.map_height, request.side) && header.height > 0
+            && cache.size() == sizeof(CacheHeader) + static_cast<size_t>(header.width) * header.height * sizeof(SDL_Color);
+        if(valid && header.source_size == source_size) {
+            bool fresh = header.source_mtime == source_mtime;
+            const bool touched = !fresh && (fresh = CompiledMap::hashFile(source_path) == header.source_hash);
+            if(fresh) {
+                result.map_width = header.map_width;
+                result.map_height = header.map_height;
+                result.pixels.resize(header.width, header.height);
+                memcpy(result.pixels.data(), cache.data() + sizeof(CacheHeader), result.pixels.cells.size() * sizeof(SDL_Color));
+                cache.close();
+                if(touched) {
+                    header.source_mtime = source_mtime; // so it doesn't have to be hashed again next time
+                    writeCache(cache_path, header, result.pixels);
+                }
+                return true;
+            }
+        }
+    }
+    cache.close();
+
+    MapPixels full;
+    if(!getBMPPixels(source_path, full, &result.map_width, &result.map_height)) { return false; }
+    // nearest pixel instead of averaging, map colors mean tile types and a blend of two of them means nothing
+    const uint32_t width  = std::min(result.map_width,  request.side);
+    const uint32_t height = std::min(result.map_height, request.side);
+    result.pixels.resize(width, height);
+    for(uint32_t y=0; y<height; ++y) {
+        const uint32_t source_y = static_cast<uint32_t>((static_cast<uint64_t>(2*y + 1) * result.map_height) / (2*height));
+        const SDL_Color* source_row = full[source_y];
+        SDL_Color* row = result.pixels[y];
+        for(uint32_t x=0; x<width; ++x) {
+            row[x] = source_row[(static_cast<uint64_t>(2*x + 1) * result.map_width) / (2*width)];
+        }
+    }
+
+    header = {
+        CACHE_MAGIC, CACHE_VERSION,
+        source_mtime, source_size, CompiledMap::hashFile(source_path),
+        result.map_width, result.map_height,
+        width, height
+    };
+    if(!writeCache(cache_path, header, result.pixels)) {
+        std::cout << "Couldn't cache the thumbnail of " << source_path << '\n';
+    }
+    return true;
+}
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "Game.hpp"
+#include "Camera.hpp"
+#include "SpatialGrid.hpp"
+#include "ECS/ECS.hpp"
+
+// Shared visibility pass: once per frame the camera rectangle (in world coordinates) is run against a SpatialGrid per
+// render group, and render() only walks the entities that came out of it.
+// Groups that were never indexed (UI, already in screen coordinates) are handed back untouched.
+class Visibility {
+private:
+    std::array<SpatialGrid, maxGroups> grids;
+    std::array<std::vector<Entity*>, maxGroups> visible;
+    std::bitset<maxGroups> indexed;
+    std::bitset<maxGroups> is_static; // only rebuilt when marked dirty (e.g. tiles)
+    std::bitset<maxGroups> dirty;
+    float world_width = 0.0f;
+    float world_height = 0.0f;
+
+public:
+    SDL_FRect camera_rect = { 0.0f, 0.0f, 0.0f, 0.0f }; // world coordinates of what the screen shows
+    float padding = 16.0f; // drawn positions are interpolated, so leave a bit of slack around the screen
+
+    void setWorldBounds(float width, float height) {
+        this->world_width = width;
+        this->world_height = height;
+    }
+
+    void indexGroup(Group g, float cell_size, bool static_group) {
+        this->grids[g].setBounds(this->world_width, this->world_height, cell_size);
+        this->indexed[g] = true;
+        this->is_static[g] = static_group;
+        this->dirty[g] = true;
+    }
+
+    void markDirty(Group g) { this->dirty[g] = true; }
+
+    const SpatialGrid& getGrid(Group g) const { return this->grids[g]; }
+
+    void updateCameraRect() {
+        Vector2D corners[4];
+        Camera::getScreenCornersInWorld(corners);
+        this->camera_rect = { corners[0].x, corners[0].y, corners[2].x - corners[0].x, corners[2].y - corners[0].y };
+    }
+
+    // to be called once per frame before drawing, after Camera::refresh()
+    void refresh() {
+        updateCameraRect();
+        for(Group g=0; g<maxGroups; ++g) {
+            if(!this->indexed[g]) { continue; }
+            if(!this->is_static[g] || this->dirty[g]) {
+                this->grids[g].build(Game::manager->getGroup(g));
+                this->dirty[g] = false;
+            }
+            this->visible[g].clear();
+            this->grids[g].query(this->camera_rect, this->visible[g], this->padding);
+        }
+    }
+
+    const std::vector<Entity*>& getVisible(Group g) {
+        if(!this->indexed[g]) { return Game::manager->getGroup(g); }
+        return this->visible[g];
+    }
+
+    void clear() {
+        for(Group g=0; g<maxGroups; ++g) {
+            this->grids[g].clear();
+            this->visible[g].clear();
+        }
+        this->indexed.reset();
+        this->is_static.reset();
+        this->dirty.reset();
+    }
+};
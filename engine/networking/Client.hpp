@@ -1,8 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <array>
 #include "olcPGEX_Network.h"
 #include "MessageTypes.h"
+#include "LockstepMessages.hpp"
+#include "DroneSnapshots.hpp"
 
 class Client : public olc::net::client_interface<MessageTypes> {
 public:
@@ -60,9 +63,54 @@ void GetUsersStatus(){
     Send(msg);
 }
 
+// lets the server use this snapshot as the baseline for the next deltas
+void AcknowledgeDronesState(uint32_t sequence) {
+    olc::net::message_writer<MessageTypes> writer(MessageTypes::ClientAck_DronesState, sizeof(sequence));
+    writer.write(sequence);
+    Send(writer.share());
+}
+
+// opens the UDP channel if needed and tells the server where to send the unreliable stuff. Empty, so the server
+// only uses it to register this client's endpoint. Sent again now and then in case one gets lost.
+// `token`: the one in the ServerAccept
+void SendUdpHello(uint32_t token) {
+    if(!this->UdpEnabled() && !this->EnableUdp()) { return; }
+    olc::net::message<MessageTypes> msg;
+    msg.header.id = MessageTypes::ClientUdpHello;
+    SendUnreliable(token, msg);
+}
+
+// just the drones and where to, the server works out the paths (or in lockstep, the turn it runs on).
+// `sequence` numbers the orders of this client, the server acknowledges them with a ServerAck_Order
+// sequence (varint) | order
+void SendMoveOrder(uint32_t sequence, const MoveOrder& order) {
+    olc::net::message_writer<MessageTypes> writer(MessageTypes::ClientOrder_Move, 22 + order.net_ids.size() * 2);
+    writer.writeVarint(sequence);
+    LockstepMessages::writeOrder(writer, order);
+    Send(writer.share());
+}
+
+// tells the server what part of the map is on screen, it sends the drones outside of it less often.
+// Only goes out when it changed since the last one. x0 | y0 | x1 | y1 (2 B each, map relative)
+void SendView(const SDL_FRect& view) {
+    const std::array<uint16_t, 4> q = {
+        DroneSnapshots::quantisePosition(view.x, Game::world_map_layout_width),
+        DroneSnapshots::quantisePosition(view.y, Game::world_map_layout_height),
+        DroneSnapshots::quantisePosition(view.x + view.w, Game::world_map_layout_width),
+        DroneSnapshots::quantisePosition(view.y + view.h, Game::world_map_layout_height)
+    };
+    if(q == this->last_view) { return; }
+    this->last_view = q;
+    olc::net::message_writer<MessageTypes> writer(MessageTypes::ClientView, sizeof(q));
+    for(const uint16_t& v : q) { writer.write(v); }
+    Send(writer.share());
+}
+
 void ClientPingResponse(olc::net::message<MessageTypes>& msg) {
     // bounce back
     Send(msg);
 }
         
+private:
+std::array<uint16_t, 4> last_view = { 0, 0, 0, 0 };
 };
\ No newline at end of file
@@ -0,0 +1,413 @@
+#pragma once
+
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <unordered_map>
+#include "../Game.hpp"
+#include "../Vector2D.hpp"
+#include "../GroupLabels.hpp"
+#include "../ECS/ECS.hpp"
+#include "../ECS/TransformComponent.hpp"
+#include "olcPGEX_Network.h"
+#include "MessageTypes.h"
+
+// Quantised drone state as it goes over the wire (8 B).
+// Positions are map relative 16 bit fixed point (0 = left/top border, 65535 = right/bottom border),
+// velocities are 4.12 fixed point (drones never go past 2 units per tick of speed).
+struct DroneNetState {
+    uint16_t x = 0;
+    uint16_t y = 0;
+    int16_t vx = 0;
+    int16_t vy = 0;
+
+    bool operator==(const DroneNetState& other) const { return x == other.x && y == other.y && vx == other.vx && vy == other.vy; }
+    bool operator!=(const DroneNetState& other) const { return !(*this == other); }
+};
+
+// A full (already reconstructed) state of every drone, indexed by the drone's network id (Game::drones_by_net_id).
+struct DroneSnapshot {
+    uint32_t sequence = 0;
+    uint32_t tick = 0; // server simulation tick it was taken on
+    bool valid = false;
+    std::vector<DroneNetState> drones = {};
+};
+
+// Common bits of the server and client sides: quantisation and the snapshot history ring.
+class DroneSnapshots {
+public:
+    static const int HISTORY_SIZE = 64; // how many snapshots are kept around to be used as baselines
+    static const int KEYFRAME_INTERVAL = 50; // every client gets a full snapshot at least this often
+    static const uint32_t NO_BASELINE = 0xFFFFFFFF;
+    static constexpr float VELOCITY_SCALE = 4096.0f;
+
+    static uint16_t quantisePosition(float p, float world_size) {
+        if(world_size <= 0.0f) { return 0; }
+        return static_cast<uint16_t>(std::clamp(std::lround((p / world_size) * 65535.0f), 0L, 65535L));
+    }
+    static float dequantisePosition(uint16_t q, float world_size) {
+        return (q / 65535.0f) * world_size;
+    }
+    static int16_t quantiseVelocity(float v) {
+        return static_cast<int16_t>(std::clamp(std::lround(v * VELOCITY_SCALE), -32768L, 32767L));
+    }
+    static float dequantiseVelocity(int16_t q) {
+        return q / VELOCITY_SCALE;
+    }
+
+    static DroneNetState quantise(const TransformComponent& t) {
+        DroneNetState s;
+        s.x = quantisePosition(t.position.x, Game::world_map_layout_width);
+        s.y = quantisePosition(t.position.y, Game::world_map_layout_height);
+        s.vx = quantiseVelocity(t.velocity.x);
+        s.vy = quantiseVelocity(t.velocity.y);
+        return s;
+    }
+    static void apply(const DroneNetState& s, TransformComponent& t) {
+        t.position.x = dequantisePosition(s.x, Game::world_map_layout_width);
+        t.position.y = dequantisePosition(s.y, Game::world_map_layout_height);
+        t.velocity.x = dequantiseVelocity(s.vx);
+        t.velocity.y = dequantiseVelocity(s.vy);
+    }
+
+    DroneSnapshot& slot(uint32_t sequence) { return this->history[sequence % HISTORY_SIZE]; }
+
+    // nullptr if that snapshot already fell out of the history
+    const DroneSnapshot* find(uint32_t sequence) const {
+        if(sequence == NO_BASELINE) { return nullptr; }
+        const DroneSnapshot& s = this->history[sequence % HISTORY_SIZE];
+        if(!s.valid || s.sequence != sequence) { return nullptr; }
+        return &s;
+    }
+
+    void clear() {
+        for(DroneSnapshot& s : this->history) {
+            s.valid = false;
+            s.drones.clear();
+        }
+    }
+
+protected:
+    std::array<DroneSnapshot, HISTORY_SIZE> history;
+};
+
+
+
+// Server side: once per broadcast take a snapshot of every drone and send each client only what changed since the last
+// snapshot it acknowledged. With a relevance filter (interest management), drones that aren't relevant to a client only
+// go out every LOW_RATE_INTERVAL snapshots, so what a client holds can lag behind the server's snapshot: the deltas are
+// made against a per client copy of what it rebuilt, not against the server's history. Keyframes are always complete.
+// Wire format of a ServerState_Drones part (message_writer, front to back):
+//   sequence (4 B) | server tick (4 B) | baseline sequence (4 B, NO_BASELINE on keyframes) | part index (2 B) | parts total (2 B) | count (2 B)
+//   count * { drone net id (varint, 1 ~ 3 B) | DroneNetState (8 B) }
+class DroneSnapshotSender : public DroneSnapshots {
+private:
+    struct ClientBaselines {
+        uint32_t acked = NO_BASELINE;         // newest acknowledged snapshot
+        uint32_t last_keyframe = NO_BASELINE; // sequence of the last keyframe sent
+        std::array<DroneSnapshot, HISTORY_SIZE> sent; // what the client rebuilds from every snapshot sent to it
+    };
+    uint32_t next_sequence = 0;
+    std::unordered_map<uint32_t, ClientBaselines> clients = {};
+    std::vector<uint32_t> changed = {};
+    uint32_t keyframe_sequence = NO_BASELINE;
+    std::vector<olc::net::shared_message<MessageTypes>> keyframe_parts = {};
+
+public:
+    const int PACKET_SIZE = 1300;
+    static const int PART_HEADER_SIZE = 18;
+    static const int ENTRY_SIZE = 11; // worst case, ids under 128 only take 9
+    static const uint32_t LOW_RATE_INTERVAL = 5; // drones not relevant to a client go out in one of this many snapshots
+
+    // store the current state of every drone as the newest snapshot, returns its sequence
+    uint32_t capture(const std::vector<Entity*>& drones, uint32_t tick) {
+        const uint32_t sequence = this->next_sequence++;
+        DroneSnapshot& s = slot(sequence);
+        s.sequence = sequence;
+        s.tick = tick;
+        s.valid = true;
+        s.drones.resize(drones.size());
+        for(size_t i=0; i<drones.size(); ++i) {
+            s.drones[i] = quantise(drones[i]->getComponent<TransformComponent>());
+        }
+        return sequence;
+    }
+
+    void acknowledge(uint32_t client_id, uint32_t sequence) {
+        auto it = this->clients.find(client_id);
+        if(it == this->clients.end()) { return; } // never sent it anything
+        if(it->second.acked == NO_BASELINE || sequence > it->second.acked) {
+            it->second.acked = sequence;
+        }
+    }
+
+    void removeClient(uint32_t client_id) {
+        this->clients.erase(client_id);
+    }
+
+    /**
+     * build the messages for one client against its acknowledged baseline (or a keyframe), returns how many drones went out.
+     * `relevant`: indexed by net id, drones set to 0 only go out on the client's low rate snapshots. nullptr sends everything
+     */
+    int buildMessages(uint32_t client_id, uint32_t sequence, std::vector<olc::net::shared_message<MessageTypes>>& out, const std::vector<uint8_t>* relevant = nullptr) {
+        const DroneSnapshot& current = slot(sequence);
+        const DroneSnapshot* baseline = nullptr;
+        ClientBaselines& client = this->clients[client_id];
+
+        const bool keyframe_due = client.last_keyframe == NO_BASELINE || sequence - client.last_keyframe >= KEYFRAME_INTERVAL;
+        if(!keyframe_due && client.acked != NO_BASELINE && sequence - client.acked < HISTORY_SIZE) {
+            const DroneSnapshot& acked = client.sent[client.acked % HISTORY_SIZE];
+            // drones were added since then, the indices can't be trusted
+            if(acked.valid && acked.sequence == client.acked && acked.drones.size() == current.drones.size()) { baseline = &acked; }
+        }
+        if(baseline == nullptr) {
+            client.last_keyframe = sequence;
+        }
+
+        // staggered by client id so the low rate snapshots of every client don't all land on the same broadcast
+        const bool low_rate_due = (sequence + client_id) % LOW_RATE_INTERVAL == 0;
+        const bool filtered = relevant != nullptr && !low_rate_due && relevant->size() >= current.drones.size();
+        this->changed.clear();
+        for(size_t i=0; i<current.drones.size(); ++i) {
+            if(baseline == nullptr || (baseline->drones[i] != current.drones[i] && (!filtered || (*relevant)[i]))) {
+                this->changed.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        // nothing moved since the baseline: stay quiet, the baseline is still good until the next keyframe
+        if(baseline != nullptr && this->changed.empty()) { return 0; }
+
+        // what the client will have once it rebuilds this one, the baseline of the next deltas
+        const uint32_t baseline_sequence = baseline ? baseline->sequence : NO_BASELINE;
+        DroneSnapshot& mirror = client.sent[sequence % HISTORY_SIZE];
+        if(baseline) {
+            mirror.drones = baseline->drones;
+            for(const uint32_t& index : this->changed) { mirror.drones[index] = current.drones[index]; }
+        } else {
+            mirror.drones = current.drones;
+        }
+        mirror.sequence = sequence;
+        mirror.tick = current.tick;
+        mirror.valid = true;
+
+        // every client due a keyframe on this snapshot gets the exact same bytes, only serialise them once
+        if(baseline == nullptr && this->keyframe_sequence == sequence) {
+            out.insert(out.end(), this->keyframe_parts.begin(), this->keyframe_parts.end());
+            return static_cast<int>(this->changed.size());
+        }
+
+        const int per_part = std::max(1, (this->PACKET_SIZE - PART_HEADER_SIZE) / ENTRY_SIZE);
+        // a keyframe of an empty match still goes out as one empty part so the client can acknowledge it
+        const uint16_t parts_total = static_cast<uint16_t>(std::max<size_t>(1, (this->changed.size() + per_part - 1) / per_part));
+        const size_t first_part = out.size();
+        for(uint16_t part=0; part<parts_total; ++part) {
+            const size_t begin = part * per_part;
+            const size_t end = std::min(this->changed.size(), begin + per_part);
+            olc::net::message_writer<MessageTypes> writer(MessageTypes::ServerState_Drones, PART_HEADER_SIZE + (end - begin) * ENTRY_SIZE);
+            writer.write(sequence)
+                  .write(current.tick)
+                  .write(baseline_sequence)
+                  .write(part)
+                  .write(parts_total)
+                  .write(static_cast<uint16_t>(end - begin));
+            for(size_t j=begin; j<end; ++j) {
+                const uint32_t index = this->changed[j];
+                const DroneNetState& s = current.drones[index];
+                writer.writeVarint(index).write(s.x).write(s.y).write(s.vx).write(s.vy);
+            }
+            out.push_back(writer.share());
+        }
+        if(baseline == nullptr) {
+            this->keyframe_sequence = sequence;
+            this->keyframe_parts.assign(out.begin() + first_part, out.end());
+        }
+        return static_cast<int>(this->changed.size());
+    }
+
+    void reset() {
+        this->next_sequence = 0;
+        this->clients.clear();
+        this->keyframe_sequence = NO_BASELINE;
+        this->keyframe_parts.clear();
+        clear();
+    }
+};
+
+
+
+// Client side: rebuild every snapshot from its baseline and acknowledge it once all of its parts arrived. What to do with it
+// (prediction for the player's own drones, interpolation for the rest) is up to the caller, see latest().
+class DroneSnapshotReceiver : public DroneSnapshots {
+private:
+    DroneSnapshot building;
+    uint16_t parts_received = 0;
+    uint32_t last_complete = NO_BASELINE;
+
+public:
+    /**
+     * reads one ServerState_Drones part. `drones` only fills in whatever a keyframe doesn't have.
+     * returns true when the snapshot is complete, then `out_sequence` holds the sequence to acknowledge
+     */
+    bool read(const olc::net::message<MessageTypes>& msg, std::vector<Entity*>& drones, uint32_t& out_sequence) {
+        olc::net::message_reader<MessageTypes> reader(msg);
+        uint32_t sequence, tick, baseline_sequence;
+        uint16_t part, parts_total, count;
+        reader.read(sequence);
+        reader.read(tick);
+        reader.read(baseline_sequence);
+        reader.read(part);
+        reader.read(parts_total);
+        reader.read(count);
+        if(!reader.ok()) { return false; }
+
+        if(part == 0) {
+            // over UDP an older snapshot can still show up after a newer one was applied
+            if(this->last_complete != NO_BASELINE && static_cast<int32_t>(sequence - this->last_complete) <= 0) { return false; }
+            const DroneSnapshot* baseline = find(baseline_sequence);
+            if(baseline_sequence != NO_BASELINE && baseline == nullptr) {
+                // the server thinks we still have it, we don't. Drop it and wait for the next keyframe
+                std::cout << "WARNING: missing baseline " << baseline_sequence << " for snapshot " << sequence << '\n';
+                this->parts_received = 0;
+                this->building.valid = false;
+                return false;
+            }
+            this->building.sequence = sequence;
+            this->building.tick = tick;
+            this->building.valid = true;
+            if(baseline) {
+                this->building.drones = baseline->drones;
+            } else {
+                // keyframe: anything not in it stays as it is locally
+                this->building.drones.resize(drones.size());
+                for(size_t i=0; i<drones.size(); ++i) {
+                    this->building.drones[i] = quantise(drones[i]->getComponent<TransformComponent>());
+                }
+            }
+            this->parts_received = 0;
+        } else if(!this->building.valid || this->building.sequence != sequence) {
+            return false; // a part of a snapshot we already dropped
+        }
+
+        uint32_t index;
+        DroneNetState s;
+        for(uint16_t i=0; i<count; ++i) {
+            reader.readVarint(index);
+            reader.read(s.x);
+            reader.read(s.y);
+            reader.read(s.vx);
+            reader.read(s.vy);
+            if(!reader.ok()) { break; }
+            if(index >= this->building.drones.size()) { continue; }
+            this->building.drones[index] = s;
+        }
+
+        ++this->parts_received;
+        if(this->parts_received < parts_total) { return false; }
+
+        this->last_complete = sequence;
+
+        DroneSnapshot& stored = slot(sequence);
+        stored = this->building;
+        this->building.valid = false;
+        out_sequence = sequence;
+        return true;
+    }
+
+    // newest complete snapshot, nullptr until one arrives
+    const DroneSnapshot* latest() const { return find(this->last_complete); }
+
+    void reset() {
+        this->building = DroneSnapshot();
+        this->parts_received = 0;
+        this->last_complete = NO_BASELINE;
+        clear();
+    }
+};
+
+
+
+// Client side: drones the player doesn't own are shown a bit in the past, between the two snapshots around the playback tick,
+// instead of snapping to every snapshot as it arrives. Keeping DELAY_SNAPSHOTS of them buffered absorbs the jitter, and the
+// playback speeds up or slows down a little to stay that far behind the newest one.
+class DroneInterpolationBuffer {
+public:
+    static const size_t CAPACITY = 16;
+    static constexpr float DELAY_SNAPSHOTS = 2.0f;
+
+private:
+    std::deque<DroneSnapshot> snapshots = {};
+    float playback_tick = 0.0f;
+    float snapshot_interval = 1.0f; // server ticks between snapshots, smoothed
+    bool playing = false;
+    // set by advance(): the playback tick falls between these two with this weight
+    size_t from = 0, to = 0;
+    float alpha = 0.0f;
+
+public:
+    void push(const DroneSnapshot& s) {
+        if(!this->snapshots.empty()) {
+            if(s.tick <= this->snapshots.back().tick) { return; }
+            this->snapshot_interval += ((s.tick - this->snapshots.back().tick) - this->snapshot_interval) * 0.1f;
+        }
+        this->snapshots.push_back(s);
+        if(this->snapshots.size() > CAPACITY) { this->snapshots.pop_front(); }
+    }
+
+    // once per client tick, before sample()
+    void advance() {
+        if(this->snapshots.empty()) { return; }
+        const float target = this->snapshots.back().tick - DELAY_SNAPSHOTS * this->snapshot_interval;
+        if(!this->playing || std::fabs(target - this->playback_tick) > CAPACITY * this->snapshot_interval) {
+            this->playback_tick = target; // first snapshot or way off (stall, lag spike), just jump
+            this->playing = true;
+        } else {
+            this->playback_tick += 1.0f + std::clamp((target - this->playback_tick) * 0.05f, -0.1f, 0.1f);
+        }
+
+        this->from = 0; this->to = 0; this->alpha = 0.0f;
+        if(this->playback_tick >= this->snapshots.back().tick) {
+            this->from = this->to = this->snapshots.size() - 1; // ran out, hold the newest
+            return;
+        }
+        for(size_t i=1; i<this->snapshots.size(); ++i) {
+            if(this->playback_tick < this->snapshots[i].tick) {
+                if(this->playback_tick < this->snapshots[i-1].tick) { break; } // before the oldest one, hold it
+                this->from = i-1;
+                this->to = i;
+                this->alpha = (this->playback_tick - this->snapshots[i-1].tick) / (this->snapshots[i].tick - this->snapshots[i-1].tick);
+                break;
+            }
+        }
+    }
+
+    // state of the drone with net id `index` at the playback tick, false if there's nothing to show yet
+    bool sample(size_t index, Vector2D& out_position, Vector2D& out_velocity) const {
+        if(!this->playing) { return false; }
+        const DroneSnapshot& a = this->snapshots[this->from];
+        const DroneSnapshot& b = this->snapshots[this->to];
+        if(index >= a.drones.size() || index >= b.drones.size()) { return false; }
+        const DroneNetState& sa = a.drones[index];
+        const DroneNetState& sb = b.drones[index];
+        out_position = VecLerp(
+            Vector2D(DroneSnapshots::dequantisePosition(sa.x, Game::world_map_layout_width), DroneSnapshots::dequantisePosition(sa.y, Game::world_map_layout_height)),
+            Vector2D(DroneSnapshots::dequantisePosition(sb.x, Game::world_map_layout_width), DroneSnapshots::dequantisePosition(sb.y, Game::world_map_layout_height)),
+            this->alpha
+        );
+        out_velocity = VecLerp(
+            Vector2D(DroneSnapshots::dequantiseVelocity(sa.vx), DroneSnapshots::dequantiseVelocity(sa.vy)),
+            Vector2D(DroneSnapshots::dequantiseVelocity(sb.vx), DroneSnapshots::dequantiseVelocity(sb.vy)),
+            this->alpha
+        );
+        return true;
+    }
+
+    void reset() {
+        this->snapshots.clear();
+        this->playback_tick = 0.0f;
+        this->snapshot_interval = 1.0f;
+        this->playing = false;
+        this->from = 0; this->to = 0; this->alpha = 0.0f;
+    }
+};
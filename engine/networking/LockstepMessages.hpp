@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "../Lockstep.hpp"
+#include "olcPGEX_Network.h"
+#include "MessageTypes.h"
+
+// wire format of the move orders: ClientOrder_Move (client -> server, lockstep or not) and ServerTurn_Orders (lockstep, server -> everyone)
+namespace LockstepMessages {
+
+const uint32_t MAX_ORDER_DRONES = 1024; // don't trust a count the message can't possibly hold
+
+// net id count (varint) | net ids (varint each) | destination x, y (4 B each) | search (1 B)
+inline void writeOrder(olc::net::message_writer<MessageTypes>& writer, const MoveOrder& order) {
+    writer.writeVarint(static_cast<uint32_t>(order.net_ids.size()));
+    for(const uint32_t& id : order.net_ids) { writer.writeVarint(id); }
+    writer.write(order.destination.x).write(order.destination.y).write(static_cast<uint8_t>(order.search));
+}
+
+inline bool readOrder(olc::net::message_reader<MessageTypes>& reader, MoveOrder& order) {
+    uint32_t count;
+    if(!reader.readVarint(count) || count > MAX_ORDER_DRONES || count > reader.remaining()) { return false; }
+    order.net_ids.resize(count);
+    for(uint32_t i=0; i<count; ++i) { reader.readVarint(order.net_ids[i]); }
+    reader.read(order.destination.x);
+    reader.read(order.destination.y);
+    uint8_t search = 0;
+    reader.read(search);
+    if(search > static_cast<uint8_t>(PathSearch::JUMP_POINTS)) { return false; }
+    order.search = static_cast<PathSearch>(search);
+    return reader.ok();
+}
+
+// turn (4 B) | order count (varint) | orders
+inline olc::net::shared_message<MessageTypes> buildTurnMessage(uint32_t turn, const std::vector<MoveOrder>& orders) {
+    olc::net::message_writer<MessageTypes> writer(MessageTypes::ServerTurn_Orders, 8 + orders.size() * 17);
+    writer.write(turn).writeVarint(static_cast<uint32_t>(orders.size()));
+    for(const MoveOrder& o : orders) { writeOrder(writer, o); }
+    return writer.share();
+}
+
+inline bool readTurnMessage(const olc::net::message<MessageTypes>& msg, uint32_t& out_turn, std::vector<MoveOrder>& out_orders) {
+    olc::net::message_reader<MessageTypes> reader(msg);
+    uint32_t count;
+    reader.read(out_turn);
+    if(!reader.readVarint(count) || count > reader.remaining()) { return false; }
+    out_orders.resize(count);
+    for(uint32_t i=0; i<count; ++i) {
+        if(!readOrder(reader, out_orders[i])) { return false; }
+    }
+    return true;
+}
+
+}
@@ -16,5 +16,11 @@ enum class MessageTypes : uint32_t {
     UsersStatus,
 	ServerState_Colors,
 	ServerState_Drones,
-	ClientState_Drones
+	ServerState_Paths,
+	ServerAck_Order,
+	ClientAck_DronesState,
+	ClientUdpHello,
+	ClientView,
+	ClientOrder_Move,
+	ServerTurn_Orders
 };
\ No newline at end of file
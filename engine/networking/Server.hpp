@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <algorithm>
 #include <unordered_map>
 #include <vector>
 #include "../utils.hpp"
@@ -10,12 +11,19 @@
 #include "../Colors.hpp"
 #include "olcPGEX_Network.h"
 #include "MessageTypes.h"
+#include "DroneSnapshots.hpp"
+#include "LockstepMessages.hpp"
+#include "../PathWorkers.hpp"
+#include "../SpatialGrid.hpp"
 
 
 class Server : public olc::net::server_interface<MessageTypes> {
 public:
+/**
+ * `host_spawn`: spawn taken by the player hosting the match, {-1,-1} on a dedicated server so every spawn is up for the clients
+ */
 Server(
-    const std::vector<std::vector<SDL_Color>>& map_pixels,
+    const MapPixels& map_pixels,
     const std::pair<int,int>& host_spawn,
     const std::vector<std::pair<int,int>>& spawn_positions,
     const std::string& map_name,
@@ -46,7 +54,162 @@ void PingAllClients() {
     MessageAllClients(broadcast_msg);
 }
 
+// snapshot every drone and send each client only the drones that changed since the last snapshot it acknowledged.
+// Clients that told the server what they're looking at (ClientView) get the rest at a lower rate, see markRelevant()
+// `tick`: the simulation tick the state is from, clients line it up with ServerAck_Order and interpolate with it
+void BroadcastDronesState(uint32_t tick) {
+    const uint32_t sequence = this->snapshots.capture(Game::drones_by_net_id, tick);
+    if(!this->clients_view.empty()) {
+        if(this->interest_world_width != Game::world_map_layout_width || this->interest_world_height != Game::world_map_layout_height) {
+            this->interest_world_width = Game::world_map_layout_width;
+            this->interest_world_height = Game::world_map_layout_height;
+            this->interest_grid.setBounds(this->interest_world_width, this->interest_world_height, this->INTEREST_CELL_SIZE);
+        }
+        this->interest_grid.build(Game::drones_by_net_id);
+    }
+    for(auto& client : this->m_deqConnections) {
+        if(!client || !client->IsConnected()) { continue; } // MessageAllClients() takes care of removing them
+        const std::vector<uint8_t>* relevant = nullptr;
+        auto view = this->clients_view.find(client->GetID());
+        if(view != this->clients_view.end()) {
+            markRelevant(client->GetID(), view->second);
+            relevant = &this->relevant;
+        }
+        this->snapshot_parts.clear();
+        this->snapshots.buildMessages(client->GetID(), sequence, this->snapshot_parts, relevant);
+        for(const auto& part : this->snapshot_parts) {
+            // newest wins, so over UDP when the client has it
+            this->MessageClientUnreliable(client, part);
+        }
+    }
+}
+
+uint32_t GetClientsAmount() const { return this->clients_amount; }
+
+// the order's effects are in every snapshot taken after `tick`, so the client can stop predicting it on its own
+// client sequence (varint) | tick (4 B)
+void AcknowledgeOrder(uint32_t client_id, uint32_t client_sequence, uint32_t tick) {
+    for(auto& client : this->m_deqConnections) {
+        if(client && client->IsConnected() && client->GetID() == client_id) {
+            olc::net::message_writer<MessageTypes> writer(MessageTypes::ServerAck_Order, 9);
+            writer.writeVarint(client_sequence).write(tick);
+            client->Send(writer.share());
+            return;
+        }
+    }
+}
+
+// only orders travel from now on, must be called before anyone joins
+void EnableLockstep() { this->lockstep_mode = true; }
+bool LockstepEnabled() const { return this->lockstep_mode; }
+
+// orders from the clients (already checked) and the host's own (client_id 0). In lockstep they wait for the next turn,
+// otherwise the paths are solved off the tick by the workers and handed out in ApplySolvedPaths().
+// `client_sequence` is the client's own number for the order, it gets it back in a ServerAck_Order once it's applied
+void QueueOrder(MoveOrder&& order, uint32_t client_id = 0, uint32_t client_sequence = 0) {
+    if(this->lockstep_mode) {
+        this->pending_orders.push_back(std::move(order));
+        return;
+    }
+    ++this->order_counter;
+    this->path_requests.clear();
+    for(const uint32_t& id : order.net_ids) {
+        if(id >= Game::drones_by_net_id.size()) { continue; }
+        if(this->latest_order.size() < Game::drones_by_net_id.size()) { this->latest_order.resize(Game::drones_by_net_id.size(), 0); }
+        this->latest_order[id] = this->order_counter;
+        DroneComponent& drone = Game::drones_by_net_id[id]->getComponent<DroneComponent>();
+        drone.path_search = order.search; // its RETRACEs search the same way
+        this->path_requests.push_back({ id, this->order_counter, drone.getPosition(), order.destination, drone.tech_level, order.search });
+    }
+    this->orders_in_flight[this->order_counter] = { client_id, client_sequence, this->path_requests.size() };
+    this->path_workers.submit(this->path_requests);
+}
+
+// call once per tick, before simulating `tick`: gives the drones the paths the workers finished since the last call and
+// sends them to every client. Orders that are done get acknowledged to whoever sent them.
+// count (2 B) | count * { net id (varint) | offcourse limit (4 B) | point count (varint) | points (2+2 B each, map relative) }
+void ApplySolvedPaths(uint32_t tick) {
+    this->path_workers.collect(this->path_results);
+    if(this->path_results.empty()) { return; }
+    uint16_t drone_counter = 0;
+    olc::net::message_writer<MessageTypes> writer(MessageTypes::ServerState_Paths, this->PACKET_SIZE);
+    writer.write(drone_counter); // patched once the packet is full
+    for(PathResult& r : this->path_results) {
+        auto in_flight = this->orders_in_flight.find(r.order);
+        if(in_flight != this->orders_in_flight.end() && --in_flight->second.remaining == 0) {
+            if(in_flight->second.client_id != 0) { AcknowledgeOrder(in_flight->second.client_id, in_flight->second.client_sequence, tick); }
+            this->orders_in_flight.erase(in_flight);
+        }
+        // blocked, or the drone got another order while this one was being solved
+        if(r.path.empty() || r.net_id >= this->latest_order.size() || this->latest_order[r.net_id] != r.order) { continue; }
+        Game::drones_by_net_id[r.net_id]->getComponent<DroneComponent>().moveToPointWithPath(r.path, r.offcourse_limit);
+
+        const size_t drone_bytes = 14 + (4 * r.path.size());
+        if(drone_counter > 0 && writer.size() + drone_bytes >= this->PACKET_SIZE) {
+            writer.writeAt(0, drone_counter);
+            MessageAllClients(writer.share());
+            writer = olc::net::message_writer<MessageTypes>(MessageTypes::ServerState_Paths, this->PACKET_SIZE);
+            drone_counter = 0;
+            writer.write(drone_counter);
+        }
+        writer.writeVarint(r.net_id)
+              .write(r.offcourse_limit)
+              .writeVarint(static_cast<uint32_t>(r.path.size()));
+        for(const Vector2D& p : r.path) {
+            writer.write(DroneSnapshots::quantisePosition(p.x, Game::world_map_layout_width))
+                  .write(DroneSnapshots::quantisePosition(p.y, Game::world_map_layout_height));
+        }
+        ++drone_counter;
+    }
+    if(drone_counter > 0) {
+        writer.writeAt(0, drone_counter);
+        MessageAllClients(writer.share());
+    }
+}
+
+// on the first tick of each turn, stamps every order received since the last one with the turn it runs on and sends them to
+// everyone (an empty turn still goes out, it's what lets the clients advance). `local` is this machine's own simulation
+void SealTurn(uint64_t tick, Lockstep& local) {
+    if(tick % Lockstep::TURN_TICKS != 0) { return; }
+    const uint32_t turn = Lockstep::turnOf(tick) + Lockstep::INPUT_DELAY_TURNS;
+    olc::net::shared_message<MessageTypes> msg = LockstepMessages::buildTurnMessage(turn, this->pending_orders);
+    MessageAllClients(msg);
+    if(!this->pending_orders.empty()) { this->turn_history.push_back(msg); }
+    local.addTurn(turn, std::move(this->pending_orders));
+    this->pending_orders = {};
+}
+
 protected:
+// drones that get the full rate for this client: whatever is on its screen, and whatever is near its own drones (about to
+// show up, and its prediction collides with it). Uses the grid built in BroadcastDronesState()
+void markRelevant(uint32_t client_id, const SDL_FRect& view) {
+    this->relevant.assign(Game::drones_by_net_id.size(), 0);
+    this->interest_query.clear();
+    this->interest_grid.query(view, this->interest_query, this->INTEREST_VIEW_PADDING);
+
+    auto color = this->clients_color.find(client_id);
+    this->interest_cells.clear();
+    if(color != this->clients_color.end()) {
+        for(Entity* e : Game::drones_by_net_id) {
+            DroneComponent& drone = e->getComponent<DroneComponent>();
+            if(drone.color_type != color->second) { continue; }
+            this->relevant[drone.net_id] = 1;
+            this->interest_cells.push_back(this->interest_grid.cellOf(drone.getPosition()));
+        }
+    }
+    // one query per cell with own drones in it, not one per drone
+    std::sort(this->interest_cells.begin(), this->interest_cells.end());
+    this->interest_cells.erase(std::unique(this->interest_cells.begin(), this->interest_cells.end()), this->interest_cells.end());
+    for(const int& cell : this->interest_cells) {
+        this->interest_grid.query(this->interest_grid.cellRect(cell), this->interest_query, this->INTEREST_OWN_RADIUS);
+    }
+    for(Entity* e : this->interest_query) {
+        this->relevant[e->getComponent<DroneComponent>().net_id] = 1;
+    }
+}
+
+DroneSnapshotSender snapshots;
+std::vector<olc::net::shared_message<MessageTypes>> snapshot_parts = {};
 std::string name; // dummy ip localhost
 std::string map_name;
 uint16_t port;
@@ -57,6 +220,31 @@ std::vector<std::pair<MainColors, bool>> colors_on_spawn = {}; // flag true if u
 std::unordered_map<uint32_t, int> clients_ping = {};
 std::unordered_map<uint32_t, MainColors> clients_color = {};
 std::unordered_map<uint32_t, bool> requested_ping = {};
+std::unordered_map<uint32_t, SDL_FRect> clients_view = {}; // world rectangle each client has on screen
+SpatialGrid interest_grid;
+float interest_world_width = 0.0f;
+float interest_world_height = 0.0f;
+std::vector<Entity*> interest_query = {};
+std::vector<int> interest_cells = {};
+std::vector<uint8_t> relevant = {}; // net id -> full rate for the client being built
+const float INTEREST_CELL_SIZE = 8.0f * Game::DOUBLE_UNIT_SIZE;
+const float INTEREST_VIEW_PADDING = 4.0f * Game::DOUBLE_UNIT_SIZE; // a bit past the screen edges, the camera moves between updates
+const float INTEREST_OWN_RADIUS = 6.0f * Game::DOUBLE_UNIT_SIZE;
+const int PACKET_SIZE = 1300; // the ideal max size in bytes
+bool lockstep_mode = false;
+PathWorkers path_workers;
+std::vector<PathRequest> path_requests = {};
+std::vector<PathResult> path_results = {};
+std::vector<uint32_t> latest_order = {}; // net id -> newest order given to that drone
+uint32_t order_counter = 0;
+struct OrderInFlight {
+    uint32_t client_id;
+    uint32_t client_sequence;
+    size_t remaining; // paths not back from the workers yet
+};
+std::unordered_map<uint32_t, OrderInFlight> orders_in_flight = {}; // server order number -> who's waiting on it
+std::vector<MoveOrder> pending_orders = {}; // for the next turn to be sealed
+std::vector<olc::net::shared_message<MessageTypes>> turn_history = {}; // every sealed turn that had orders, replayed to late joiners
 
 virtual bool OnClientConnect(std::shared_ptr<olc::net::connection<MessageTypes>> client) {
     this->clients_amount++;
@@ -74,6 +262,8 @@ virtual bool OnClientConnect(std::shared_ptr<olc::net::connection<MessageTypes>>
     olc::net::message<MessageTypes> msg;
     // send their ID and relevant information to create the scene
     msg.header.id = MessageTypes::ServerAccept;
+    msg << client->UdpToken();
+    msg << static_cast<uint8_t>(this->lockstep_mode);
     for(int i=0; i<this->spawn_pos.size(); ++i) {
         msg << this->spawn_pos[i].second;
         msg << this->spawn_pos[i].first;
@@ -85,6 +275,10 @@ virtual bool OnClientConnect(std::shared_ptr<olc::net::connection<MessageTypes>>
     msg << this->nIDCounter;
     msg <= this->name;
     client->Send(msg);
+    // the client starts the match from tick 0, it simulates everything that already happened to get here
+    for(const auto& turn : this->turn_history) {
+        client->Send(turn);
+    }
     return true;
 }
 
@@ -113,10 +307,17 @@ virtual bool OnClientConnect(std::shared_ptr<olc::net::connection<MessageTypes>>
             std::cout << "Removing client [" << client_id << "]\n";
             this->clients_ping.erase(client_id);
             this->clients_color.erase(client_id);
+            this->clients_view.erase(client_id);
+            this->snapshots.removeClient(client_id);
         }
 
 
 
+        // only what's fine to lose or get twice
+        bool OnUnreliableAllowed(MessageTypes id) override {
+            return id == MessageTypes::ClientUdpHello || id == MessageTypes::ClientAck_DronesState || id == MessageTypes::ClientView;
+        }
+
         virtual void OnMessage(std::shared_ptr<olc::net::connection<MessageTypes>> client, olc::net::message<MessageTypes>& msg) {
             uint32_t client_id = client->GetID();
 
@@ -192,42 +393,46 @@ virtual bool OnClientConnect(std::shared_ptr<olc::net::connection<MessageTypes>>
                     }
                 } break;
 
-                case MessageTypes::ClientState_Drones: {
-                    // since the packet takes some time to arrive, 
-                    // the drone should be moved forward on its path by the number of frames equivalent to the time it took to get the packet
-                    // in order to sync it with the client
-                    int average_frames_passed = static_cast<int>((this->clients_ping[client_id]/1000.0f) * Game::AVERAGE_FPS);
-                    DroneComponent* drone;
-                    int drone_counter;
-                    int drone_path_size;
-                    float drone_offcourse_limit;
-                    std::string drone_id;
-                    std::vector<Vector2D> drone_path;
-                    Vector2D v;
-                    Vector2D previous_pos;
-                    msg >> drone_counter;
-                    for(int i=0; i<drone_counter; ++i) {
-                        msg >= drone_id;
-                        msg >> drone_offcourse_limit;
-                        msg >> drone_path_size;
-                        drone_path = {};
-                        for(int j=0; j<drone_path_size; ++j) {
-                            msg >> v.x;
-                            msg >> v.y;
-                            drone_path.push_back(v);
-                        }
-                        drone = &Game::manager->getEntityFromGroup(drone_id, groupDrones)->getComponent<DroneComponent>();
-                        drone->moveToPointWithPath(drone_path, drone_offcourse_limit);
-                        // sync on path / roll forward if needed
-                        for(int j=0; j<average_frames_passed; ++j) {
-                            previous_pos = drone->transform->position;
-                            drone->preUpdate();
-                            drone->update();
-                            drone->handleStaticCollisions(previous_pos, Game::manager->getGroup(groupTiles), Game::manager->getGroup(groupBuildings));
-                            drone->handleDynamicCollisions(Game::manager->getGroup(groupDrones));
-                            drone->handleCollisionTranslations();
-                            drone->handleOutOfBounds(Game::world_map_layout_width, Game::world_map_layout_height);
-                        }                        
+                case MessageTypes::ClientAck_DronesState: {
+                    uint32_t sequence;
+                    olc::net::message_reader<MessageTypes> reader(msg);
+                    if(reader.read(sequence)) {
+                        this->snapshots.acknowledge(client_id, sequence);
+                    }
+                } break;
+
+                case MessageTypes::ClientView: {
+                    // x0 | y0 | x1 | y1, map relative like the drone positions (2 B each)
+                    uint16_t q[4];
+                    olc::net::message_reader<MessageTypes> reader(msg);
+                    for(uint16_t& v : q) { reader.read(v); }
+                    if(!reader.ok()) { break; }
+                    const float x0 = DroneSnapshots::dequantisePosition(q[0], Game::world_map_layout_width);
+                    const float y0 = DroneSnapshots::dequantisePosition(q[1], Game::world_map_layout_height);
+                    const float x1 = DroneSnapshots::dequantisePosition(q[2], Game::world_map_layout_width);
+                    const float y1 = DroneSnapshots::dequantisePosition(q[3], Game::world_map_layout_height);
+                    this->clients_view[client_id] = { x0, y0, std::max(0.0f, x1 - x0), std::max(0.0f, y1 - y0) };
+                } break;
+
+                case MessageTypes::ClientOrder_Move: {
+                    MoveOrder order;
+                    uint32_t client_sequence;
+                    olc::net::message_reader<MessageTypes> reader(msg);
+                    if(!reader.readVarint(client_sequence) || !LockstepMessages::readOrder(reader, order)) {
+                        std::cout << "[" << client_id << "]: malformed ClientOrder_Move\n";
+                        break;
+                    }
+                    // players only get to move their own drones
+                    const MainColors color = this->clients_color[client_id];
+                    order.net_ids.erase(std::remove_if(order.net_ids.begin(), order.net_ids.end(), [&color](const uint32_t& id) {
+                        return id >= Game::drones_by_net_id.size() || Game::drones_by_net_id[id]->getComponent<DroneComponent>().color_type != color;
+                    }), order.net_ids.end());
+                    std::sort(order.net_ids.begin(), order.net_ids.end());
+                    order.net_ids.erase(std::unique(order.net_ids.begin(), order.net_ids.end()), order.net_ids.end());
+                    if(order.net_ids.empty()) {
+                        AcknowledgeOrder(client_id, client_sequence, 0); // nothing to do, don't leave it waiting
+                    } else {
+                        QueueOrder(std::move(order), client_id, client_sequence);
                     }
                 } break;
             }
@@ -71,6 +71,12 @@
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <atomic>
+#include <random>
 
 #ifdef _WIN32
 #ifndef _WIN32_WINNT
@@ -144,6 +150,12 @@ namespace olc
 			uint32_t size = 0;
 		};
 
+		// wraps an integer to be sent in as few bytes as possible, e.g. `msg << olc::net::varint{ id };`
+		struct varint
+		{
+			uint32_t value = 0;
+		};
+
 		// Message Body contains a header and a std::vector, containing raw bytes
 		// of infomation. This way the message can be variable length, but the size
 		// in the header must be updated.
@@ -220,13 +232,12 @@ namespace olc
 			}
 
 			// Pushes std::string data into the message buffer as a sequence of char's (size first, then inverted byte-string)
+			// the chars go in with a single copy, popping them back as one block keeps the same layout
 			friend message<T>& operator <= (message<T>& msg, const std::string& data) {
-				// byte array;
-				char const *c = data.c_str();
 				int string_size = data.size();
-				for(int i=0; i<string_size; ++i) {
-					msg << c[i];
-				}
+				size_t i = msg.body.size();
+				msg.body.resize(i + string_size);
+				std::memcpy(msg.body.data() + i, data.data(), string_size);
 				msg << string_size;
 
 				// Return the target message so it can be "chained"
@@ -237,18 +248,244 @@ namespace olc
 			friend message<T>& operator >= (message<T>& msg, std::string& data) {
 				int string_size;
 				msg >> string_size;
-				char c;
-				std::string temp;
-				for(int i=0; i<string_size; ++i) {
-					msg >> c;
-					temp += c;
-				}
-				std::reverse(temp.begin(), temp.end());
-				data = temp;
+				size_t i = msg.body.size() - string_size;
+				data.assign(reinterpret_cast<const char*>(msg.body.data() + i), string_size);
+				msg.body.resize(i);
+				msg.header.size = msg.size();
 
 				// Return the target message so it can be "chained"
 				return msg;
 			}
+
+			// Pushes an unsigned integer in 1 to 5 bytes (7 bits per byte, the high bit flags that another byte follows).
+			// Bytes go in most significant group first so they come back out least significant first
+			friend message<T>& operator << (message<T>& msg, const varint& v) {
+				uint8_t bytes[5];
+				int count = 0;
+				uint32_t value = v.value;
+				do {
+					bytes[count] = value & 0x7F;
+					value >>= 7;
+					if(value != 0) { bytes[count] |= 0x80; }
+					++count;
+				} while(value != 0);
+				size_t i = msg.body.size();
+				msg.body.resize(i + count);
+				for(int j=0; j<count; ++j) {
+					msg.body[i + j] = bytes[count-1-j];
+				}
+				msg.header.size = msg.size();
+				return msg;
+			}
+
+			// Pulls an integer pushed as a varint
+			friend message<T>& operator >> (message<T>& msg, varint& v) {
+				uint32_t value = 0;
+				int shift = 0;
+				uint8_t byte;
+				do {
+					byte = msg.body.back();
+					msg.body.pop_back();
+					value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+					shift += 7;
+				} while((byte & 0x80) && shift < 35);
+				msg.header.size = msg.size();
+				v.value = value;
+				return msg;
+			}
+		};
+
+
+		// A finished message shared between every connection it goes out on: a broadcast is serialised once and each
+		// connection's out queue only holds a reference to it
+		template <typename T>
+		using shared_message = std::shared_ptr<const message<T>>;
+
+
+		// Recycles message bodies so steady traffic stops going through the allocator: message_writer takes its body
+		// from here, and shared messages and received messages hand theirs back once nobody needs them. The vectors keep
+		// their capacity, so after the first few ticks writing a message is just a memcpy. Shared by every thread
+		class buffer_pool
+		{
+		public:
+			static buffer_pool& instance()
+			{
+				static buffer_pool pool;
+				return pool;
+			}
+
+			// an empty vector with at least `reserve_bytes` of capacity
+			std::vector<uint8_t> acquire(size_t reserve_bytes)
+			{
+				std::vector<uint8_t> body;
+				{
+					std::scoped_lock lock(muxPool);
+					if (!vFree.empty())
+					{
+						body = std::move(vFree.back());
+						vFree.pop_back();
+					}
+				}
+				body.clear();
+				body.reserve(reserve_bytes);
+				return body;
+			}
+
+			void release(std::vector<uint8_t>&& body)
+			{
+				// nothing worth keeping, or so big it would just sit there (e.g. the map data)
+				if (body.capacity() == 0 || body.capacity() > MAX_POOLED_CAPACITY) return;
+				std::scoped_lock lock(muxPool);
+				if (vFree.size() < MAX_POOLED) vFree.push_back(std::move(body));
+			}
+
+		private:
+			static const size_t MAX_POOLED = 256;
+			static const size_t MAX_POOLED_CAPACITY = 64 * 1024;
+			std::mutex muxPool;
+			std::vector<std::vector<uint8_t>> vFree;
+		};
+
+		// a shared_message whose body goes back to the buffer_pool once the last connection sent it
+		template <typename T>
+		shared_message<T> make_shared_message(message<T>&& msg)
+		{
+			return shared_message<T>(new message<T>(std::move(msg)), [](const message<T>* m)
+				{
+					buffer_pool::instance().release(std::move(const_cast<message<T>*>(m)->body));
+					delete m;
+				});
+		}
+
+		// same, copying `msg` into a pooled body (for messages built with operator <<)
+		template <typename T>
+		shared_message<T> make_shared_message(const message<T>& msg)
+		{
+			message<T> copy;
+			copy.header = msg.header;
+			copy.body = buffer_pool::instance().acquire(msg.body.size());
+			copy.body.assign(msg.body.begin(), msg.body.end());
+			return make_shared_message(std::move(copy));
+		}
+
+
+		// Builds a message front to back into a buffer reserved up front (no reallocation while writing, no reversed
+		// packing). Only readable with message_reader, not with operator >>
+		template <typename T>
+		class message_writer
+		{
+		public:
+			message_writer(T id, size_t reserve_bytes = 0)
+			{
+				msg.header.id = id;
+				msg.body = buffer_pool::instance().acquire(reserve_bytes);
+			}
+
+			template<typename DataType>
+			message_writer<T>& write(const DataType& data)
+			{
+				static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be pushed into vector");
+				size_t i = msg.body.size();
+				msg.body.resize(i + sizeof(DataType));
+				std::memcpy(msg.body.data() + i, &data, sizeof(DataType));
+				return *this;
+			}
+
+			// overwrite something already written, e.g. a count only known once everything else is in
+			template<typename DataType>
+			void writeAt(size_t offset, const DataType& data)
+			{
+				std::memcpy(msg.body.data() + offset, &data, sizeof(DataType));
+			}
+
+			// 7 bits per byte, least significant group first, the high bit flags that another byte follows
+			message_writer<T>& writeVarint(uint32_t value)
+			{
+				do {
+					uint8_t byte = value & 0x7F;
+					value >>= 7;
+					if (value != 0) byte |= 0x80;
+					msg.body.push_back(byte);
+				} while (value != 0);
+				return *this;
+			}
+
+			message_writer<T>& writeString(const std::string& data)
+			{
+				writeVarint(static_cast<uint32_t>(data.size()));
+				size_t i = msg.body.size();
+				msg.body.resize(i + data.size());
+				std::memcpy(msg.body.data() + i, data.data(), data.size());
+				return *this;
+			}
+
+			size_t size() const { return msg.body.size(); }
+
+			// hand over the finished message (the writer is left empty)
+			message<T> finish()
+			{
+				msg.header.size = msg.size();
+				return std::move(msg);
+			}
+
+			shared_message<T> share()
+			{
+				return make_shared_message(finish());
+			}
+
+		private:
+			message<T> msg;
+		};
+
+		// Reads a message_writer's message front to back without touching the body. Every read returns false (and
+		// ok() turns false) instead of reading past the end of a short/malformed message
+		template <typename T>
+		class message_reader
+		{
+		public:
+			message_reader(const message<T>& m) : msg(m) {}
+
+			template<typename DataType>
+			bool read(DataType& data)
+			{
+				static_assert(std::is_standard_layout<DataType>::value, "Data is too complex to be read from vector");
+				if (cursor + sizeof(DataType) > msg.body.size()) { failed = true; return false; }
+				std::memcpy(&data, msg.body.data() + cursor, sizeof(DataType));
+				cursor += sizeof(DataType);
+				return true;
+			}
+
+			bool readVarint(uint32_t& value)
+			{
+				value = 0;
+				for (int shift = 0; shift < 35; shift += 7)
+				{
+					if (cursor >= msg.body.size()) { failed = true; return false; }
+					uint8_t byte = msg.body[cursor++];
+					value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+					if (!(byte & 0x80)) return true;
+				}
+				failed = true;
+				return false;
+			}
+
+			bool readString(std::string& data)
+			{
+				uint32_t string_size;
+				if (!readVarint(string_size)) return false;
+				if (cursor + string_size > msg.body.size()) { failed = true; return false; }
+				data.assign(reinterpret_cast<const char*>(msg.body.data() + cursor), string_size);
+				cursor += string_size;
+				return true;
+			}
+
+			size_t remaining() const { return msg.body.size() - cursor; }
+			bool ok() const { return !failed; }
+
+		private:
+			const message<T>& msg;
+			size_t cursor = 0;
+			bool failed = false;
 		};
 
 
@@ -319,6 +556,15 @@ namespace olc
 
 			// Adds an item to back of Queue
 			void push_back(const T& item)
+			{
+				std::scoped_lock lock(muxQueue);
+				deqQueue.push_back(item);
+
+				std::unique_lock<std::mutex> ul(muxBlocking);
+				cvBlocking.notify_one();
+			}
+
+			void push_back(T&& item)
 			{
 				std::scoped_lock lock(muxQueue);
 				deqQueue.push_back(std::move(item));
@@ -327,6 +573,14 @@ namespace olc
 				cvBlocking.notify_one();
 			}
 
+			// Moves every queued item to the back of `out` under a single lock
+			void drain(std::vector<T>& out)
+			{
+				std::scoped_lock lock(muxQueue);
+				for (T& item : deqQueue) out.push_back(std::move(item));
+				deqQueue.clear();
+			}
+
 			// Adds an item to front of Queue
 			void push_front(const T& item)
 			{
@@ -374,6 +628,301 @@ namespace olc
 			std::mutex muxBlocking;
 		};
 		
+		// Single producer / single consumer queue: a bounded lock-free ring for the normal case, used for what the asio
+		// thread hands to the game loop (received messages and datagrams). Only ever one thread pushing and one popping,
+		// so each side just publishes its own index. If the ring is full (e.g. the match history replayed to a late
+		// joiner while the game isn't reading) the producer spills into a locked deque instead of blocking the asio
+		// thread, and keeps spilling until the consumer caught up, so the order is never broken
+		template<typename T, size_t Capacity = 1024>
+		class spsc_queue
+		{
+			static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+		public:
+			spsc_queue() = default;
+			spsc_queue(const spsc_queue<T, Capacity>&) = delete;
+
+			// Producer side
+			void push_back(T&& item)
+			{
+				// only the producer ever raises the flag, so seeing it down means the ring is fine to use
+				if (!m_bSpilling.load(std::memory_order_acquire))
+				{
+					const size_t tail = m_nTail.load(std::memory_order_relaxed);
+					if (tail - m_nHead.load(std::memory_order_acquire) < Capacity)
+					{
+						m_aSlots[tail & (Capacity - 1)] = std::move(item);
+						m_nTail.store(tail + 1, std::memory_order_release);
+						notify();
+						return;
+					}
+				}
+				{
+					std::scoped_lock lock(muxSpill);
+					m_deqSpill.push_back(std::move(item));
+					m_bSpilling.store(true, std::memory_order_release);
+				}
+				notify();
+			}
+
+			void push_back(const T& item)
+			{
+				push_back(T(item));
+			}
+
+			// Consumer side: false if there was nothing
+			bool try_pop(T& out)
+			{
+				if (pop_ring(out)) return true;
+				if (!m_bSpilling.load(std::memory_order_acquire)) return false;
+				std::scoped_lock lock(muxSpill);
+				// the producer may have filled the ring between the check above and the spill, those are older than it.
+				// It doesn't touch the ring while the flag is up, so once that's empty whatever spilled is next
+				if (pop_ring(out)) return true;
+				if (m_deqSpill.empty()) return false;
+				out = std::move(m_deqSpill.front());
+				m_deqSpill.pop_front();
+				if (m_deqSpill.empty()) m_bSpilling.store(false, std::memory_order_release);
+				return true;
+			}
+
+			// Consumer side: moves everything available to the back of `out` in one go
+			void drain(std::vector<T>& out)
+			{
+				drain_ring(out);
+				if (!m_bSpilling.load(std::memory_order_acquire)) return;
+				std::scoped_lock lock(muxSpill);
+				drain_ring(out); // same as in try_pop: what made it into the ring before the spill goes first
+				for (T& item : m_deqSpill) out.push_back(std::move(item));
+				m_deqSpill.clear();
+				m_bSpilling.store(false, std::memory_order_release);
+			}
+
+			// Consumer side, like tsqueue: only call it when !empty()
+			T pop_front()
+			{
+				T item;
+				try_pop(item);
+				return item;
+			}
+
+			bool empty() const
+			{
+				return m_nHead.load(std::memory_order_acquire) == m_nTail.load(std::memory_order_acquire)
+					&& !m_bSpilling.load(std::memory_order_acquire);
+			}
+
+			// Consumer side: block until something arrives
+			void wait()
+			{
+				std::unique_lock<std::mutex> ul(muxBlocking);
+				m_bWaiting = true;
+				// the timeout covers a push landing between the check and the wait
+				while (empty()) cvBlocking.wait_for(ul, std::chrono::milliseconds(1));
+				m_bWaiting = false;
+			}
+
+		private:
+			void notify()
+			{
+				if (m_bWaiting.load(std::memory_order_relaxed)) cvBlocking.notify_one();
+			}
+
+			bool pop_ring(T& out)
+			{
+				const size_t head = m_nHead.load(std::memory_order_relaxed);
+				if (head == m_nTail.load(std::memory_order_acquire)) return false;
+				out = std::move(m_aSlots[head & (Capacity - 1)]);
+				m_nHead.store(head + 1, std::memory_order_release);
+				return true;
+			}
+
+			void drain_ring(std::vector<T>& out)
+			{
+				const size_t head = m_nHead.load(std::memory_order_relaxed);
+				const size_t tail = m_nTail.load(std::memory_order_acquire);
+				for (size_t i = head; i != tail; ++i)
+					out.push_back(std::move(m_aSlots[i & (Capacity - 1)]));
+				m_nHead.store(tail, std::memory_order_release);
+			}
+
+			std::array<T, Capacity> m_aSlots;
+			alignas(64) std::atomic<size_t> m_nHead{ 0 }; // next slot to pop, written by the consumer
+			alignas(64) std::atomic<size_t> m_nTail{ 0 }; // next slot to push, written by the producer
+			alignas(64) std::atomic<bool> m_bSpilling{ false };
+			std::mutex muxSpill;
+			std::deque<T> m_deqSpill;
+			std::atomic<bool> m_bWaiting{ false };
+			std::condition_variable cvBlocking;
+			std::mutex muxBlocking;
+		};
+
+		// UDP
+		// A datagram as it arrived, before anyone decided who it belongs to
+		template <typename T>
+		struct udp_datagram
+		{
+			uint32_t sender_token = 0; // a client's connection token (see connection::UdpToken), 0 from the server
+			uint32_t sequence = 0; // the sender's own count, whoever knows the sender keeps only the newest
+			asio::ip::udp::endpoint endpoint;
+			message<T> msg;
+		};
+
+		// v4 peers show up as v4-mapped v6 addresses on the dual-stack sockets, compare them as plain v4
+		inline asio::ip::address normalise_address(const asio::ip::address& address)
+		{
+			if (address.is_v6() && address.to_v6().is_v4_mapped())
+				return asio::ip::make_address_v4(asio::ip::v4_mapped, address.to_v6());
+			return address;
+		}
+
+		// Unreliable, unordered channel for state that is only worth having when it's the newest (e.g. drone snapshots).
+		// Runs on the same asio context as the TCP connections. Every datagram is:
+		//   message_header<T> | sequence (4 B) | sender token (4 B) | body
+		// The channel doesn't know who is allowed to talk to it, so it drops nothing but garbage. Whoever does (the client
+		// checks the address, the server the token too) keeps only the newest: the client through AcceptServerSequence(),
+		// the server per client in server_interface::Update()
+		template <typename T>
+		class udp_channel
+		{
+		public:
+			static constexpr size_t MAX_DATAGRAM_SIZE = 1472; // 1500 B MTU - IP and UDP headers, avoids fragmentation
+			static constexpr size_t PREFIX_SIZE = sizeof(message_header<T>) + 2 * sizeof(uint32_t);
+
+			udp_channel(asio::io_context& asioContext) : m_asioContext(asioContext), m_socket(asioContext) {}
+
+			virtual ~udp_channel()
+			{
+				CloseSocket();
+			}
+
+			// where the datagrams that survived go, called from the asio thread
+			void SetReceiver(std::function<void(udp_datagram<T>&&)> receiver)
+			{
+				m_receiver = std::move(receiver);
+			}
+
+			// port 0 lets the OS pick one (clients)
+			bool Open(uint16_t port, bool dual_stack = true)
+			{
+				try
+				{
+					if (dual_stack)
+					{
+						m_socket.open(asio::ip::udp::v6());
+						m_socket.set_option(asio::ip::v6_only(false));
+						m_socket.bind(asio::ip::udp::endpoint(asio::ip::udp::v6(), port));
+					}
+					else
+					{
+						m_socket.open(asio::ip::udp::v4());
+						m_socket.bind(asio::ip::udp::endpoint(asio::ip::udp::v4(), port));
+					}
+				}
+				catch (std::exception& e)
+				{
+					std::cout << "[UDP] Could not open port " << port << ": " << e.what() << "\n";
+					CloseSocket();
+					return false;
+				}
+				asio::post(m_asioContext, [this]() { Receive(); });
+				return true;
+			}
+
+			bool IsOpen() const
+			{
+				return m_socket.is_open();
+			}
+
+			// newest wins (wrap around safe). For the datagrams of the server only, and only once they are known to be
+			// from it. Called from the asio thread, in the receiver
+			bool AcceptServerSequence(uint32_t sequence)
+			{
+				if (m_bHasSequenceIn && static_cast<int32_t>(sequence - m_nLastSequenceIn) <= 0) return false;
+				m_nLastSequenceIn = sequence;
+				m_bHasSequenceIn = true;
+				return true;
+			}
+
+			void Close()
+			{
+				asio::post(m_asioContext, [this]() { CloseSocket(); });
+			}
+
+			// ASYNC - the message is shared, the same one can go to any number of endpoints
+			void SendTo(const asio::ip::udp::endpoint& endpoint, uint32_t sender_token, shared_message<T> msg)
+			{
+				if (msg->body.size() + PREFIX_SIZE > MAX_DATAGRAM_SIZE)
+				{
+					std::cout << "[UDP] Datagram too big (" << msg->body.size() << " B), not sent\n";
+					return;
+				}
+				asio::post(m_asioContext,
+					[this, endpoint, sender_token, msg]()
+					{
+						auto prefix = std::make_shared<std::array<uint32_t, 2>>(std::array<uint32_t, 2>{ m_nSequenceOut++, sender_token });
+						std::array<asio::const_buffer, 3> buffers = {
+							asio::buffer(&msg->header, sizeof(message_header<T>)),
+							asio::buffer(prefix->data(), sizeof(uint32_t) * 2),
+							asio::buffer(msg->body.data(), msg->body.size())
+						};
+						m_socket.async_send_to(buffers, endpoint,
+							[msg, prefix](std::error_code ec, std::size_t length)
+							{
+								// unreliable by design, a failed send is just a lost datagram
+							});
+					});
+			}
+
+		private:
+			void CloseSocket()
+			{
+				try { if (m_socket.is_open()) m_socket.close(); }
+				catch (std::exception&) {}
+			}
+
+			// ASYNC - wait for the next datagram, forever
+			void Receive()
+			{
+				m_socket.async_receive_from(asio::buffer(m_bufferIn), m_remoteIn,
+					[this](std::error_code ec, std::size_t length)
+					{
+						if (!ec)
+						{
+							HandleDatagram(length);
+						}
+						if (m_socket.is_open()) // closed means we are done, any other error just means that one datagram is lost
+						{
+							Receive();
+						}
+					});
+			}
+
+			void HandleDatagram(std::size_t length)
+			{
+				if (length < PREFIX_SIZE) return;
+				udp_datagram<T> datagram;
+				std::memcpy(&datagram.msg.header, m_bufferIn.data(), sizeof(message_header<T>));
+				std::memcpy(&datagram.sequence, m_bufferIn.data() + sizeof(message_header<T>), sizeof(uint32_t));
+				std::memcpy(&datagram.sender_token, m_bufferIn.data() + sizeof(message_header<T>) + sizeof(uint32_t), sizeof(uint32_t));
+				if (datagram.msg.header.size != length - PREFIX_SIZE) return; // truncated or garbage
+
+				datagram.msg.body.assign(m_bufferIn.begin() + PREFIX_SIZE, m_bufferIn.begin() + length);
+				datagram.endpoint = m_remoteIn;
+				if (m_receiver) m_receiver(std::move(datagram));
+			}
+
+			asio::io_context& m_asioContext;
+			asio::ip::udp::socket m_socket;
+			asio::ip::udp::endpoint m_remoteIn;
+			std::array<uint8_t, MAX_DATAGRAM_SIZE> m_bufferIn;
+			std::function<void(udp_datagram<T>&&)> m_receiver;
+			uint32_t m_nLastSequenceIn = 0; // from the server, only touched by the asio thread
+			bool m_bHasSequenceIn = false;
+			uint32_t m_nSequenceOut = 0; // only touched by the asio thread
+		};
+
+
 		// Connection
 		// Forward declare
 		template<typename T>
@@ -394,7 +943,7 @@ namespace olc
 		public:
 			// Constructor: Specify Owner, connect to context, transfer the socket
 			//				Provide reference to incoming message queue
-			connection(owner parent, asio::io_context& asioContext, asio::ip::tcp::socket socket, tsqueue<owned_message<T>>& qIn)
+			connection(owner parent, asio::io_context& asioContext, asio::ip::tcp::socket socket, spsc_queue<owned_message<T>>& qIn)
 				: m_asioContext(asioContext), m_socket(std::move(socket)), m_qMessagesIn(qIn)
 			{
 
@@ -409,6 +958,10 @@ namespace olc
 
 					// Pre-calculate the result for checking when the client responds
 					m_nHandshakeCheck = scramble(m_nHandshakeOut);
+
+					// what the client signs its datagrams with. Random, unlike the ids, so nobody else can pass for it
+					std::random_device rd;
+					do { m_nUdpToken = rd(); } while (m_nUdpToken == 0);
 				}
 				else
 				{
@@ -437,6 +990,8 @@ namespace olc
 					{
 						m_socket.set_option(olc::net::no_nagle);
 						id = uid;
+						try { m_remoteAddress = normalise_address(m_socket.remote_endpoint().address()); }
+						catch (std::exception&) {} // already gone, nothing will match it
 
 						// Was: ReadHeader();
 
@@ -496,6 +1051,18 @@ namespace olc
 				return m_bConnectionEstablished;
 			}
 
+			// where the client connected from, to check UDP datagrams claiming to be this client
+			const asio::ip::address& RemoteAddress() const
+			{
+				return m_remoteAddress;
+			}
+
+			// server side only: the token this client's datagrams have to carry. It gets it in the accept message
+			uint32_t UdpToken() const
+			{
+				return m_nUdpToken;
+			}
+
 			// Prime the connection to wait for incoming messages
 			void StartListening()
 			{
@@ -507,100 +1074,61 @@ namespace olc
 			// the target, for a client, the target is the server and vice versa
 			void Send(const message<T>& msg)
 			{
-				asio::post(m_asioContext,
-					[this, msg]()
-					{
-						// If the queue has a message in it, then we must 
-						// assume that it is in the process of asynchronously being written.
-						// Either way add the message to the queue to be output. If no messages
-						// were available to be written, then start the process of writing the
-						// message at the front of the queue.
-						bool bWritingMessage = !m_qMessagesOut.empty();
-						m_qMessagesOut.push_back(msg);
-						if (!bWritingMessage)
-						{
-							WriteHeader();
-						}
-					});
+				Send(make_shared_message(msg));
+			}
+
+			// the same message can be queued on any number of connections, it's only freed once all of them sent it.
+			// Queued straight away, the asio thread picks up everything queued since its last write in one go
+			void Send(shared_message<T> msg)
+			{
+				m_qMessagesOut.push_back(std::move(msg));
+				// only the first message since the last flush has to wake the asio thread up
+				if (!m_bWriteScheduled.exchange(true))
+					asio::post(m_asioContext, [this]() { WriteQueued(); });
 			}
 
 
 
 		private:
-			// ASYNC - Prime context to write a message header
-			void WriteHeader()
+			// ASYNC - Write every queued message (headers and bodies) with a single gather write, one syscall per batch
+			// instead of two per message. Only ever runs on the asio thread, one batch at a time
+			void WriteQueued()
 			{
-				// If this function is called, we know the outgoing message queue must have 
-				// at least one message to send. So allocate a transmission buffer to hold
-				// the message, and issue the work - asio, send these bytes
-				asio::async_write(m_socket, asio::buffer(&m_qMessagesOut.front().header, sizeof(message_header<T>)),
+				m_vWriting.clear();
+				m_qMessagesOut.drain(m_vWriting);
+				if (m_vWriting.empty())
+				{
+					m_bWriteScheduled = false;
+					// a Send() may have queued something after the drain but before the flag went down
+					if (m_qMessagesOut.empty() || m_bWriteScheduled.exchange(true)) return;
+					m_qMessagesOut.drain(m_vWriting);
+				}
+
+				m_vWriteBuffers.clear();
+				for (const shared_message<T>& msg : m_vWriting)
+				{
+					m_vWriteBuffers.push_back(asio::buffer(&msg->header, sizeof(message_header<T>)));
+					if (msg->body.size() > 0)
+						m_vWriteBuffers.push_back(asio::buffer(msg->body.data(), msg->body.size()));
+				}
+
+				asio::async_write(m_socket, m_vWriteBuffers,
 					[this](std::error_code ec, std::size_t length)
 					{
-						// asio has now sent the bytes - if there was a problem
-						// an error would be available...
 						if (!ec)
 						{
-							// ... no error, so check if the message header just sent also
-							// has a message body...
-							if (m_qMessagesOut.front().body.size() > 0)
-							{
-								// ...it does, so issue the task to write the body bytes
-								WriteBody();
-							}
-							else
-							{
-								// ...it didnt, so we are done with this message. Remove it from 
-								// the outgoing message queue
-								m_qMessagesOut.pop_front();
-
-								// If the queue is not empty, there are more messages to send, so
-								// make this happen by issuing the task to send the next header.
-								if (!m_qMessagesOut.empty())
-								{
-									WriteHeader();
-								}
-							}
+							// done with this batch, anything sent meanwhile goes out in the next one
+							WriteQueued();
 						}
 						else
 						{
-							std::cout << "Error on WriteHeader(): " << ec.message() << " (" << std::to_string(ec.value()) << ")\n";
-							// ...asio failed to write the message, we could analyse why but 
+							std::cout << "Error on WriteQueued(): " << ec.message() << " (" << std::to_string(ec.value()) << ")\n";
+							// ...asio failed to write the messages, we could analyse why but 
 							// for now simply assume the connection has died by closing the
 							// socket. When a future attempt to write to this client fails due
 							// to the closed socket, it will be tidied up.
-							std::cout << "[" << id << "] Write Header Fail.\n";
-							m_socket.close();
-						}
-					});
-			}
-
-			// ASYNC - Prime context to write a message body
-			void WriteBody()
-			{
-				// If this function is called, a header has just been sent, and that header
-				// indicated a body existed for this message. Fill a transmission buffer
-				// with the body data, and send it!
-				asio::async_write(m_socket, asio::buffer(m_qMessagesOut.front().body.data(), m_qMessagesOut.front().body.size()),
-					[this](std::error_code ec, std::size_t length)
-					{
-						if (!ec)
-						{
-							// Sending was successful, so we are done with the message
-							// and remove it from the queue
-							m_qMessagesOut.pop_front();
-
-							// If the queue still has messages in it, then issue the task to 
-							// send the next messages' header.
-							if (!m_qMessagesOut.empty())
-							{
-								WriteHeader();
-							}
-						}
-						else
-						{
-							std::cout << "Error on WriteBody(): " << ec.message() << '\n';
-							// Sending failed, see WriteHeader() equivalent for description :P
-							std::cout << "[" << id << "] Write Body Fail.\n";
+							std::cout << "[" << id << "] Write Fail.\n";
+							m_vWriting.clear();
 							m_socket.close();
 						}
 					});
@@ -750,11 +1278,14 @@ namespace olc
 			void AddToIncomingMessageQueue()
 			{				
 				// Shove it in queue, converting it to an "owned message", by initialising
-				// with the a shared pointer from this connection object
+				// with the a shared pointer from this connection object. The body moves along with it
+				// (whoever handles it can give it back to the buffer_pool), the next one gets a pooled one
 				if(m_nOwnerType == owner::server)
-					m_qMessagesIn.push_back({ this->shared_from_this(), m_msgTemporaryIn });
+					m_qMessagesIn.push_back({ this->shared_from_this(), std::move(m_msgTemporaryIn) });
 				else
-					m_qMessagesIn.push_back({ nullptr, m_msgTemporaryIn });
+					m_qMessagesIn.push_back({ nullptr, std::move(m_msgTemporaryIn) });
+				m_msgTemporaryIn.header = {};
+				m_msgTemporaryIn.body = buffer_pool::instance().acquire(0);
 
 				// We must now prime the asio context to receive the next message. It 
 				// wil just sit and wait for bytes to arrive, and the message construction
@@ -771,10 +1302,14 @@ namespace olc
 
 			// This queue holds all messages to be sent to the remote side
 			// of this connection
-			tsqueue<message<T>> m_qMessagesOut;
+			tsqueue<shared_message<T>> m_qMessagesOut;
+			// the batch being written right now, and the header/body buffers pointing into it
+			std::vector<shared_message<T>> m_vWriting;
+			std::vector<asio::const_buffer> m_vWriteBuffers;
+			std::atomic<bool> m_bWriteScheduled{ false };
 
-			// This references the incoming queue of the parent object
-			tsqueue<owned_message<T>>& m_qMessagesIn;
+			// This references the incoming queue of the parent object, only ever pushed to from the asio thread
+			spsc_queue<owned_message<T>>& m_qMessagesIn;
 
 			// Incoming messages are constructed asynchronously, so we will
 			// store the part assembled message here, until it is ready
@@ -794,6 +1329,8 @@ namespace olc
 
 
 			uint32_t id = 0;
+			asio::ip::address m_remoteAddress;
+			uint32_t m_nUdpToken = 0;
 
 		};
 		
@@ -826,6 +1363,8 @@ namespace olc
 					
 					// Tell the connection object to connect to server
 					m_connection->ConnectToServer(endpoints);			
+					m_sHost = host;
+					m_nPort = port;
 
 					// Start Context Thread
 					thrContext = std::thread([this]() { m_context.run(); });
@@ -843,6 +1382,9 @@ namespace olc
 				if(IsConnected()) {
 					m_connection->Disconnect();
 				}
+				if (m_udp.IsOpen()) {
+					m_udp.Close();
+				}
 
 				// Either way, we're also done with the asio context...				
 				m_context.stop();
@@ -871,8 +1413,51 @@ namespace olc
 					 m_connection->Send(msg);
 			}
 
+			void Send(shared_message<T> msg)
+			{
+				if (IsConnected())
+					 m_connection->Send(std::move(msg));
+			}
+
+			// Open the UDP channel to the same host and port as the TCP connection. The server only starts using it once
+			// a datagram from this client (see SendUnreliable) made it there
+			bool EnableUdp()
+			{
+				if (m_udp.IsOpen()) return true;
+				try
+				{
+					asio::ip::udp::resolver resolver(m_context);
+					m_udpServer = *resolver.resolve(m_sHost, std::to_string(m_nPort)).begin();
+				}
+				catch (std::exception& e)
+				{
+					std::cerr << "[UDP] Could not resolve " << m_sHost << ": " << e.what() << "\n";
+					return false;
+				}
+				m_udp.SetReceiver([this](udp_datagram<T>&& datagram)
+					{
+						// only the server may talk to us on this socket
+						if (normalise_address(datagram.endpoint.address()) != normalise_address(m_udpServer.address())) return;
+						if (datagram.sender_token != 0 || !m_udp.AcceptServerSequence(datagram.sequence)) return;
+						m_qMessagesIn.push_back({ nullptr, std::move(datagram.msg) });
+					});
+				return m_udp.Open(0, m_udpServer.address().is_v6());
+			}
+
+			bool UdpEnabled() const
+			{
+				return m_udp.IsOpen();
+			}
+
+			// `token` is the one the server sent this client when it accepted it, it's how the server knows who sent the datagram
+			void SendUnreliable(uint32_t token, const message<T>& msg)
+			{
+				if (IsConnected() && m_udp.IsOpen())
+					m_udp.SendTo(m_udpServer, token, make_shared_message(msg));
+			}
+
 			// Retrieve queue of messages from server
-			tsqueue<owned_message<T>>& Incoming()
+			spsc_queue<owned_message<T>>& Incoming()
 			{ 
 				return m_qMessagesIn;
 			}
@@ -884,10 +1469,15 @@ namespace olc
 			std::thread thrContext;
 			// The client has a single instance of a "connection" object, which handles data transfer
 			std::unique_ptr<connection<T>> m_connection;
+			// plus an optional unreliable channel for state updates
+			udp_channel<T> m_udp{ m_context };
+			asio::ip::udp::endpoint m_udpServer;
+			std::string m_sHost;
+			uint16_t m_nPort = 0;
 			
 		private:
-			// This is the thread safe queue of incoming messages from server
-			tsqueue<owned_message<T>> m_qMessagesIn;
+			// This is the thread safe queue of incoming messages from server (asio thread -> game loop)
+			spsc_queue<owned_message<T>> m_qMessagesIn;
 		};
 		
 		// Server
@@ -897,7 +1487,7 @@ namespace olc
 		public:
 			// Create a server, ready to listen on specified port
 			server_interface(uint16_t port)
-				: m_asioAcceptor(m_asioContext)
+				: m_asioAcceptor(m_asioContext), m_udp(m_asioContext), m_nPort(port)
 			{
 				asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v6(), port);
 
@@ -930,6 +1520,10 @@ namespace olc
 					// connect.
 					WaitForClientConnection();
 
+					// UDP on the same port number. Not having it isn't fatal, clients just keep getting everything over TCP
+					m_udp.SetReceiver([this](udp_datagram<T>&& datagram) { m_qUdpIn.push_back(std::move(datagram)); });
+					m_udp.Open(m_nPort);
+
 					// Launch the asio context in its own thread
 					m_threadContext = std::thread([this]() { m_asioContext.run(); });
 				}
@@ -1027,6 +1621,7 @@ namespace olc
 					// well remove the client - let the server know, it may
 					// be tracking it somehow
 					OnClientDisconnect(client);
+					ForgetUdpClient(client);
 
 					// Off you go now, bye bye!
 					client.reset();
@@ -1046,6 +1641,7 @@ namespace olc
 						}
 					} else {
 						OnClientDisconnect(client);
+						ForgetUdpClient(client);
 						client.reset();
 						m_deqConnections.erase(
 							std::remove(m_deqConnections.begin(), m_deqConnections.end(), client), m_deqConnections.end());
@@ -1055,6 +1651,11 @@ namespace olc
 			
 			// Send message to all clients
 			void MessageAllClients(const message<T>& msg, std::shared_ptr<connection<T>> pIgnoreClient = nullptr) {
+				// serialise once, every connection just references it
+				MessageAllClients(make_shared_message(msg), pIgnoreClient);
+			}
+
+			void MessageAllClients(shared_message<T> msg, std::shared_ptr<connection<T>> pIgnoreClient = nullptr) {
 				bool bInvalidClientExists = false;
 
 				// Iterate through all clients in container
@@ -1070,6 +1671,7 @@ namespace olc
 						// The client couldnt be contacted, so assume it has
 						// disconnected.
 						OnClientDisconnect(client);
+						ForgetUdpClient(client);
 						
 						client.reset();
 
@@ -1085,21 +1687,87 @@ namespace olc
 						std::remove(m_deqConnections.begin(), m_deqConnections.end(), nullptr), m_deqConnections.end());
 			}
 
+			// Send a message that's fine to lose (only the newest one matters) to a specific client. Goes over UDP once
+			// that client has said hello on it, over TCP until then
+			void MessageClientUnreliable(std::shared_ptr<connection<T>> client, shared_message<T> msg)
+			{
+				if (client && client->IsConnected())
+				{
+					auto endpoint = m_udpEndpoints.find(client->GetID());
+					if (endpoint != m_udpEndpoints.end())
+					{
+						m_udp.SendTo(endpoint->second, 0, std::move(msg));
+						return;
+					}
+					client->Send(std::move(msg));
+				}
+				else
+				{
+					MessageClient(client, *msg);
+				}
+			}
+
+			// once a client is gone, nothing of it stays behind for the UDP side
+			void ForgetUdpClient(const std::shared_ptr<connection<T>>& client)
+			{
+				if (!client) return;
+				m_udpEndpoints.erase(client->GetID());
+				m_udpLastSequence.erase(client->GetID());
+			}
+
 			// Force server to respond to incoming messages
 			void Update(size_t nMaxMessages = -1, bool bWait = false)
 			{
 				if (bWait) m_qMessagesIn.wait();
 
+				// datagrams first
+				m_vUdpBatch.clear();
+				m_qUdpIn.drain(m_vUdpBatch);
+				for (udp_datagram<T>& datagram : m_vUdpBatch)
+				{
+					// anything that has to be reliable (orders, disconnects, ...) only counts over TCP
+					if (!OnUnreliableAllowed(datagram.msg.header.id)) continue;
+
+					// the token has to be a connected client's, and it has to come from the same address
+					if (datagram.sender_token == 0) continue;
+					auto client = std::find_if(m_deqConnections.begin(), m_deqConnections.end(),
+						[&datagram](const std::shared_ptr<connection<T>>& c) { return c && c->IsConnected() && c->UdpToken() == datagram.sender_token; });
+					if (client == m_deqConnections.end()) continue;
+					if ((*client)->RemoteAddress() != normalise_address(datagram.endpoint.address())) continue;
+
+					const uint32_t client_id = (*client)->GetID();
+
+					// newest wins (wrap around safe), counted per client now that it's known to be theirs
+					auto last = m_udpLastSequence.find(client_id);
+					if (last != m_udpLastSequence.end() && static_cast<int32_t>(datagram.sequence - last->second) <= 0) continue;
+					m_udpLastSequence[client_id] = datagram.sequence;
+
+					auto endpoint = m_udpEndpoints.find(client_id);
+					if (endpoint == m_udpEndpoints.end())
+					{
+						std::cout << "[" << client_id << "] UDP endpoint registered\n";
+						m_udpEndpoints[client_id] = datagram.endpoint;
+					}
+					else
+					{
+						endpoint->second = datagram.endpoint; // NAT may have remapped the port
+					}
+
+					// empty datagrams are just hellos/keepalives
+					if (datagram.msg.body.size() > 0)
+						OnMessage(*client, datagram.msg);
+				}
+
 				// Process as many messages as you can up to the value
 				// specified
 				size_t nMessageCount = 0;
-				while (nMessageCount < nMaxMessages && !m_qMessagesIn.empty())
+				owned_message<T> msg;
+				while (nMessageCount < nMaxMessages && m_qMessagesIn.try_pop(msg))
 				{
-					// Grab the front message
-					auto msg = m_qMessagesIn.pop_front();
-
 					// Pass to message handler
 					OnMessage(msg.remote, msg.msg);
+					buffer_pool::instance().release(std::move(msg.msg.body));
+					msg.remote.reset();
 
 					nMessageCount++;
 				}
@@ -1127,6 +1795,12 @@ namespace olc
 
 			}
 
+			// Which message types may come over UDP. Anything else in a datagram is dropped before it gets anywhere
+			virtual bool OnUnreliableAllowed(T id)
+			{
+				return false;
+			}
+
 		public:
 			// Called when a client is validated
 			virtual void OnClientValidated(std::shared_ptr<connection<T>> client)
@@ -1137,7 +1811,7 @@ namespace olc
 
 		protected:
 			// Thread Safe Queue for incoming message packets
-			tsqueue<owned_message<T>> m_qMessagesIn;
+			spsc_queue<owned_message<T>> m_qMessagesIn;
 
 			// Container of active validated connections
 			std::deque<std::shared_ptr<connection<T>>> m_deqConnections;
@@ -1149,6 +1823,14 @@ namespace olc
 			// These things need an asio context
 			asio::ip::tcp::acceptor m_asioAcceptor; // Handles new incoming connection attempts...
 
+			// ...and the unreliable channel, see MessageClientUnreliable
+			udp_channel<T> m_udp;
+			spsc_queue<udp_datagram<T>, 256> m_qUdpIn;
+			std::vector<udp_datagram<T>> m_vUdpBatch;
+			std::unordered_map<uint32_t, asio::ip::udp::endpoint> m_udpEndpoints; // client id -> where its datagrams come from
+			std::unordered_map<uint32_t, uint32_t> m_udpLastSequence; // client id -> newest datagram sequence taken from it
+			uint16_t m_nPort;
+
 			// Clients will be identified in the "wider system" via an ID
 			uint32_t nIDCounter = 10000;
 
@@ -6,6 +6,9 @@
 #include <chrono>
 #include <queue>
 #include <unordered_set>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include "Game.hpp"
 #include "Vector2D.hpp"
 #include "ECS/ECS.hpp"
@@ -131,71 +134,124 @@ Vector2D convertMacroMeshNodeToVector2D(const MeshNode& n, const int macro_size)
 }
 
 
-float nodeTypeCost(const MeshNode& n, const std::vector<std::vector<uint8_t>>& mesh) {
-    // FAR FUTURE TODO: make these values related to techs
-    switch(mesh[n.y][n.x]) {
-        case TILE_PLAIN: return 0.0f;
-        case TILE_ROUGH: return 20.0f;
-        case TILE_NAVIGABLE: return 10.0f;
-        // case TILE_BASE_SPAWN: <-
-        // case TILE_IMPASSABLE: <- these two never get to be walkable
-        default: return 0.0f;
+// What crossing each tile type costs, relative to TILE_PLAIN. Infinity means it can't be walked on at all.
+// One table per tech level, so whatever a tech unlocks only has to change the table the path is searched with.
+struct TerrainCosts {
+    std::array<float, TILE_PLAYER + 1> multiplier;
+    float cheapest; // smallest multiplier, so the heuristic never guesses more than a path could cost
+    // weighted A*: > 1 lets a path cost up to `weight` times the cheapest one, in exchange for expanding way fewer nodes.
+    // 1 is plain A*
+    float weight;
+
+    bool walkable(uint8_t tile) const { return this->multiplier[tile] != std::numeric_limits<float>::infinity(); }
+
+    static const TerrainCosts& forTechLevel(int tech_level) {
+        static constexpr float BLOCKED = std::numeric_limits<float>::infinity();
+        static constexpr float WEIGHT = 1.5f;
+        // DroneComponent::update() moves the drones at 1/multiplier, so these are the time it takes to cross a tile
+        static const TerrainCosts levels[] = {
+            //   PLAIN  ROUGH  IMPASSABLE NAVIGABLE BASE_SPAWN PLAYER
+            { {{ 1.0f,  2.0f,  BLOCKED,   BLOCKED,  BLOCKED,   BLOCKED }}, 1.0f, WEIGHT },
+            { {{ 1.0f,  2.0f,  BLOCKED,   1.5f,     BLOCKED,   BLOCKED }}, 1.0f, WEIGHT }  // boats
+        };
+        static constexpr int LEVELS = sizeof(levels) / sizeof(levels[0]);
+        return levels[std::min(std::max(tech_level, 0), LEVELS - 1)];
     }
-}
+};
 
 // https://idm-lab.org/bib/abstracts/papers/jair10b.pdf -> page 26 Algorithm 5
-// I changed my mind again. 
-// Maybe I'll reintroduce tile costs in some other way, 
-// but if I just add it up here, the average runtime of path finding for 1 drone jumps to 2.3ms which is kinda bad. (graph exploration grows a lot more)
-// If I leave it with just the node distance, it usually stays under 1ms.
-float heuristicCost(const MeshNode& n, const MeshNode& dest, const std::vector<std::vector<uint8_t>>& mesh) {
-    return NodeDistance(n, dest);// + nodeTypeCost(n, mesh);
-}
-
-
-void update_vertex_mesh(
-    const MeshNode& s, const MeshNode& neighbor, 
-    std::unordered_map<MeshNode, MeshNode, Node2Hash>& parent, 
-    std::unordered_map<MeshNode, float, Node2Hash>& gscore, 
-    std::unordered_map<MeshNode, float, Node2Hash>& fscore, 
-    std::priority_queue<MeshNode, std::vector<MeshNode>, NodeCompareByFScore>& open_queue,
-    std::unordered_set<MeshNode, Node2Hash>& open_set, 
-    const MeshNode& destination,
-    const std::vector<std::vector<uint8_t>>& mesh
-) {
-    float total_cost = gscore[s] + heuristicCost(s, neighbor, mesh);
-    if(total_cost < gscore[neighbor]) {
-        gscore[neighbor] = total_cost;
-        parent[neighbor] = s;
-        fscore[neighbor] = gscore[neighbor] + heuristicCost(neighbor, destination, mesh);
-        if(open_set.find(neighbor) == open_set.end()) {
-            open_set.insert(neighbor);
-        }
-        open_queue.push(neighbor);
+// Adding the tile cost on top of the squared distance made the graph exploration blow up (1ms -> 2.3ms on average for
+// 1 drone), so the costs went into the edges instead and the heuristic is the cheapest a path could possibly be:
+// octile distance (euclidean with the knight moves of branching factor 16) over the cheapest tile.
+// The search weighs it by costs.weight to go back to expanding about as few nodes as before, and on the meshes with a
+// LandmarkTable it takes the landmark bound instead whenever that one is bigger.
+float octileDistance(const MeshNode& a, const MeshNode& b) {
+    static const float DIAGONAL_EXTRA = std::sqrt(2.0f) - 1.0f;
+    const float dx = std::abs(b.x - a.x);
+    const float dy = std::abs(b.y - a.y);
+    return std::max(dx, dy) + (DIAGONAL_EXTRA * std::min(dx, dy));
+}
+
+float heuristicCost(const MeshNode& n, const MeshNode& dest, const TerrainCosts& costs, const int branching_factor) {
+    if(branching_factor == 16) {
+        const float dx = dest.x - n.x;
+        const float dy = dest.y - n.y;
+        return std::sqrt((dx*dx) + (dy*dy)) * costs.cheapest;
     }
+    return octileDistance(n, dest) * costs.cheapest;
 }
 
+// how find_path() searches. JUMP_POINTS is faster but ignores the terrain costs, see jump_point_search_mesh()
+enum class PathSearch : uint8_t {
+    A_STAR,
+    JUMP_POINTS
+};
 
-std::vector<Vector2D> reconstruct_path_macro_mesh(const MeshNode& s, std::unordered_map<MeshNode, MeshNode, Node2Hash>& parent, const int macro_size) {
-    std::vector<Vector2D> total_path = { convertMacroMeshNodeToVector2D(s, macro_size) };
-    MeshNode curr_point = s;
-    MeshNode curr_parent = parent[s];
-    while(curr_parent != curr_point) {
-        total_path.push_back(convertMacroMeshNodeToVector2D(curr_parent, macro_size));
-        curr_point = curr_parent;
-        curr_parent = parent[curr_point];
+// Everything a_star_mesh() keeps per node, as flat arrays indexed by y*width + x.
+// One per thread (PathWorkers searches on several) and only ever grown, so after the first few searches nothing is
+// allocated anymore. `state` tells which search touched a node last, so the arrays never have to be cleared.
+struct MeshSearchScratch {
+    struct OpenNode {
+        float f;
+        float g;
+        int index;
+        // the heap's top is the smallest f, ties go to the deepest node and then the lowest index, same on every machine
+        bool operator<(const OpenNode& b) const {
+            if(this->f != b.f) { return this->f > b.f; }
+            if(this->g != b.g) { return this->g < b.g; }
+            return this->index > b.index;
+        }
+    };
+
+    std::vector<float> gscore = {};
+    std::vector<int> parent = {};
+    std::vector<uint32_t> state = {}; // search << 1, plus 1 once closed
+    std::vector<OpenNode> open = {};
+    uint32_t search = 0;
+
+    void begin(size_t nodes) {
+        if(this->state.size() < nodes) {
+            this->gscore.resize(nodes);
+            this->parent.resize(nodes);
+            this->state.resize(nodes, 0);
+        }
+        this->open.clear();
+        if(++this->search == (1u << 31)) { // wrapped, old marks could pass as this search's
+            std::fill(this->state.begin(), this->state.end(), 0);
+            this->search = 1;
+        }
     }
-    return total_path;
+    bool seen(int i) const { return (this->state[i] >> 1) == this->search; }
+    bool closed(int i) const { return this->state[i] == ((this->search << 1) | 1); }
+    void close(int i) { this->state[i] = (this->search << 1) | 1; }
+    void push(int i, float g, float f, int from) {
+        this->state[i] = this->search << 1;
+        this->gscore[i] = g;
+        this->parent[i] = from;
+        this->open.push_back({ f, g, i });
+        std::push_heap(this->open.begin(), this->open.end());
+    }
+    OpenNode pop() {
+        std::pop_heap(this->open.begin(), this->open.end());
+        OpenNode top = this->open.back();
+        this->open.pop_back();
+        return top;
+    }
+};
+
+// the one of the thread searching
+MeshSearchScratch& meshSearchScratch() {
+    thread_local MeshSearchScratch scratch;
+    return scratch;
 }
 
-std::vector<Vector2D> reconstruct_path_mesh(const MeshNode& s, std::unordered_map<MeshNode, MeshNode, Node2Hash>& parent, const int mesh_density) {
-    std::vector<Vector2D> total_path = { convertMeshNodeToVector2D(s, mesh_density) };
-    MeshNode curr_point = s;
-    MeshNode curr_parent = parent[s];
-    while(curr_parent != curr_point) {
-        total_path.push_back(convertMeshNodeToVector2D(curr_parent, mesh_density));
-        curr_point = curr_parent;
-        curr_parent = parent[curr_point];
+std::vector<Vector2D> reconstruct_path_mesh(int s, const std::vector<int>& parent, const int mesh_width, const int density, const int macro_size) {
+    std::vector<Vector2D> total_path;
+    while(true) {
+        MeshNode n = { s % mesh_width, s / mesh_width };
+        total_path.push_back(macro_size > 0 ? convertMacroMeshNodeToVector2D(n, macro_size) : convertMeshNodeToVector2D(n, density));
+        if(parent[s] == s) { break; }
+        s = parent[s];
     }
     return total_path;
 }
@@ -384,33 +440,218 @@ std::vector<MeshNode> getMeshNeighbors(const int x, const int y, const int width
 }
 
 
-bool walkableInMesh(int x, int y, const std::vector<std::vector<uint8_t>>& mesh) {
+bool walkableInMesh(int x, int y, const std::vector<std::vector<uint8_t>>& mesh, const TerrainCosts& costs) {
     // mesh is indexed HEIGHT first
-    // FAR FUTURE TODO: change this to receive input of a tech level that unlocks TILE_NAVIGABLE
-    return (
-        mesh[y][x] != TILE_IMPASSABLE && 
-        mesh[y][x] != TILE_NAVIGABLE && 
-        mesh[y][x] != TILE_BASE_SPAWN &&
-        mesh[y][x] != TILE_PLAYER
-    );
+    return costs.walkable(mesh[y][x]);
+}
+
+// without any techs
+bool walkableInMesh(int x, int y, const std::vector<std::vector<uint8_t>>& mesh) {
+    return walkableInMesh(x, y, mesh, TerrainCosts::forTechLevel(0));
 }
 
-bool meshDiagonalOK(const MeshNode& s, const MeshNode& n, const std::vector<std::vector<uint8_t>>& mesh) {
+bool meshDiagonalOK(const MeshNode& s, const MeshNode& n, const std::vector<std::vector<uint8_t>>& mesh, const TerrainCosts& costs) {
     // no diagonals
     if(s.y == n.y || s.x == n.x) { return true; }
 
     if(s.x < n.x) {
         if(s.y < n.y) { // check right and top of s
-            return walkableInMesh(s.x + 1, s.y, mesh) || walkableInMesh(s.x, s.y + 1, mesh);
+            return walkableInMesh(s.x + 1, s.y, mesh, costs) || walkableInMesh(s.x, s.y + 1, mesh, costs);
         }
         // check right and bottom of s
-        return walkableInMesh(s.x + 1, s.y, mesh) || walkableInMesh(s.x, s.y - 1, mesh);
+        return walkableInMesh(s.x + 1, s.y, mesh, costs) || walkableInMesh(s.x, s.y - 1, mesh, costs);
     }
     if(s.y < n.y) { // check left and top of s
-        return walkableInMesh(s.x - 1, s.y, mesh) || walkableInMesh(s.x, s.y + 1, mesh);
+        return walkableInMesh(s.x - 1, s.y, mesh, costs) || walkableInMesh(s.x, s.y + 1, mesh, costs);
     }
     // check left bototm of s
-    return walkableInMesh(s.x - 1, s.y, mesh) || walkableInMesh(s.x, s.y - 1, mesh);
+    return walkableInMesh(s.x - 1, s.y, mesh, costs) || walkableInMesh(s.x, s.y - 1, mesh, costs);
+}
+
+
+// offsets of the neighbors of a mesh node, same order as getMeshNeighbors(): 4 sides, 4 diagonals, then 8 knight moves
+static const int MESH_OFFSETS_X[16] = { 0, 1, 0, -1,   1, 1, -1, -1,   1, 2, 2, 1, -1, -2, -2, -1 };
+static const int MESH_OFFSETS_Y[16] = { 1, 0, -1, 0,   1, -1, -1, 1,   2, 1, -1, -2, -2, -1, 1, 2 };
+
+float meshOffsetLength(int i) {
+    static const float SQRT_2 = std::sqrt(2.0f);
+    static const float SQRT_5 = std::sqrt(5.0f);
+    return i < 4 ? 1.0f : (i < 8 ? SQRT_2 : SQRT_5);
+}
+
+// ALT (A*, Landmarks, Triangle inequality), Goldberg & Harrelson: the exact cost from a few landmark nodes to every
+// node of a mesh, measured once per map. Since d(L,goal) <= d(L,n) + d(n,goal), |d(L,goal) - d(L,n)| never overestimates
+// what's left from n, and unlike the straight line it knows about the mountains and the water in between.
+// Only valid for the TerrainCosts it was built with and 8 neighbors (find_path() always uses 8).
+// Nodes one landmark reaches and the other doesn't are in pieces of the map that aren't connected, so the search can
+// drop them right away.
+class LandmarkTable {
+public:
+static const int LANDMARKS = 8;
+
+const TerrainCosts* costs = nullptr; // nullptr until built
+int width = 0;
+int height = 0;
+std::vector<int> landmarks = {};    // node indices
+std::vector<float> distances = {};  // node major: distances[(node * landmarks.size()) + landmark]
+
+bool builtFor(const TerrainCosts& c) const { return this->costs == &c; }
+
+void clear() {
+    this->costs = nullptr;
+    this->width = 0; this->height = 0;
+    this->landmarks.clear();
+    this->distances.clear();
+}
+
+// how much getting from `from` to `to` costs at least. Infinity if they aren't connected
+float lowerBound(int from, int to) const {
+    const size_t k = this->landmarks.size();
+    const float* f = &this->distances[from * k];
+    const float* t = &this->distances[to * k];
+    float bound = 0.0f;
+    for(size_t i=0; i<k; ++i) {
+        const bool f_reached = f[i] != std::numeric_limits<float>::infinity();
+        const bool t_reached = t[i] != std::numeric_limits<float>::infinity();
+        if(f_reached != t_reached) { return std::numeric_limits<float>::infinity(); }
+        if(f_reached) { bound = std::max(bound, std::abs(t[i] - f[i])); }
+    }
+    return bound;
+}
+
+// picks the landmarks farthest from each other (each one is the node furthest from the ones before it) and runs
+// Dijkstra from each. `mesh` is indexed height first, like every collision mesh
+void build(const std::vector<std::vector<uint8_t>>& mesh, const int mesh_width, const int mesh_height, const TerrainCosts& c) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    clear();
+    if(mesh_width <= 0 || mesh_height <= 0) { return; }
+    this->width = mesh_width;
+    this->height = mesh_height;
+    const size_t nodes = static_cast<size_t>(mesh_width) * mesh_height;
+
+    const int seed = biggestPieceNode(mesh, c);
+    if(seed < 0) { return; } // nothing to walk on anyway
+
+    // every landmark ends up in the biggest piece of the map, the others are small pockets the bound only has to tell apart
+    std::vector<std::vector<float>> from_landmark;
+    std::vector<float> closest(nodes, std::numeric_limits<float>::infinity()); // distance to the nearest landmark so far
+    std::vector<float> scratch;
+    dijkstra(mesh, c, seed, scratch);
+    int next = farthest(scratch);
+    while(next >= 0 && static_cast<int>(this->landmarks.size()) < LANDMARKS) {
+        this->landmarks.push_back(next);
+        from_landmark.emplace_back();
+        dijkstra(mesh, c, next, from_landmark.back());
+        const std::vector<float>& d = from_landmark.back();
+        for(size_t i=0; i<nodes; ++i) { closest[i] = std::min(closest[i], d[i]); }
+        next = farthest(closest);
+        if(next >= 0 && closest[next] <= 0.0f) { next = -1; } // every node is a landmark already
+    }
+
+    const size_t k = this->landmarks.size();
+    this->distances.resize(nodes * k);
+    for(size_t i=0; i<nodes; ++i) {
+        for(size_t l=0; l<k; ++l) { this->distances[(i * k) + l] = from_landmark[l][i]; }
+    }
+    this->costs = &c;
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "Landmarks " << mesh_width << 'x' << mesh_height << " Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+}
+
+private:
+// some node of the biggest piece of the map that's connected, -1 if nothing is walkable
+int biggestPieceNode(const std::vector<std::vector<uint8_t>>& mesh, const TerrainCosts& c) const {
+    const size_t nodes = static_cast<size_t>(this->width) * this->height;
+    std::vector<uint8_t> visited(nodes, 0);
+    std::vector<int> stack;
+    int best = -1;
+    size_t best_size = 0;
+    for(size_t i=0; i<nodes; ++i) {
+        if(visited[i] || !c.walkable(mesh[i / this->width][i % this->width])) { continue; }
+        size_t size = 0;
+        visited[i] = 1;
+        stack.push_back(static_cast<int>(i));
+        while(!stack.empty()) {
+            const int top = stack.back();
+            stack.pop_back();
+            ++size;
+            const MeshNode s = { top % this->width, top / this->width };
+            for(int o=0; o<8; ++o) {
+                const MeshNode n = { s.x + MESH_OFFSETS_X[o], s.y + MESH_OFFSETS_Y[o] };
+                if(n.x < 0 || n.y < 0 || n.x >= this->width || n.y >= this->height) { continue; }
+                const int n_index = (n.y * this->width) + n.x;
+                if(visited[n_index] || !walkableInMesh(n.x, n.y, mesh, c) || !meshDiagonalOK(s, n, mesh, c)) { continue; }
+                visited[n_index] = 1;
+                stack.push_back(n_index);
+            }
+        }
+        if(size > best_size) { best_size = size; best = static_cast<int>(i); }
+    }
+    return best;
+}
+
+// index of the biggest finite distance, the lowest index on ties. -1 if there's none
+static int farthest(const std::vector<float>& d) {
+    int best = -1;
+    for(size_t i=0; i<d.size(); ++i) {
+        if(d[i] == std::numeric_limits<float>::infinity()) { continue; }
+        if(best < 0 || d[i] > d[best]) { best = static_cast<int>(i); }
+    }
+    return best;
+}
+
+// cost from `source` to every node with the same edges a_star_mesh() uses with 8 neighbors, infinity where it can't get to
+void dijkstra(const std::vector<std::vector<uint8_t>>& mesh, const TerrainCosts& c, int source, std::vector<float>& out) const {
+    out.assign(static_cast<size_t>(this->width) * this->height, std::numeric_limits<float>::infinity());
+    std::vector<std::pair<float, int>> open;
+    out[source] = 0.0f;
+    open.push_back({ 0.0f, source });
+    while(!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<std::pair<float, int>>());
+        const std::pair<float, int> top = open.back();
+        open.pop_back();
+        if(top.first > out[top.second]) { continue; }
+
+        const MeshNode s = { top.second % this->width, top.second / this->width };
+        const float s_multiplier = c.multiplier[mesh[s.y][s.x]];
+        for(int i=0; i<8; ++i) {
+            const MeshNode n = { s.x + MESH_OFFSETS_X[i], s.y + MESH_OFFSETS_Y[i] };
+            if(n.x < 0 || n.y < 0 || n.x >= this->width || n.y >= this->height) { continue; }
+            if(!walkableInMesh(n.x, n.y, mesh, c) || !meshDiagonalOK(s, n, mesh, c)) { continue; }
+            const int n_index = (n.y * this->width) + n.x;
+            const float g = top.first + (meshOffsetLength(i) * 0.5f * (s_multiplier + c.multiplier[mesh[n.y][n.x]]));
+            if(g >= out[n_index]) { continue; }
+            out[n_index] = g;
+            open.push_back({ g, n_index });
+            std::push_heap(open.begin(), open.end(), std::greater<std::pair<float, int>>());
+        }
+    }
+}
+};
+
+// the tables of the meshes long searches run on (the finer ones only get short searches, not worth the memory).
+// Built while the match loads (MatchSimulation::loadCollisionMeshes()) and only read afterwards. nullptr for the others
+LandmarkTable* meshLandmarks(const int density, const int macro_size) {
+    static LandmarkTable mesh_1, mesh_4, macro_4;
+    if(macro_size == 4) { return &macro_4; }
+    if(macro_size > 0) { return nullptr; }
+    switch(density) {
+        case 1: return &mesh_1;
+        case 4: return &mesh_4;
+        default: return nullptr;
+    }
+}
+
+void buildMeshLandmarks(const TerrainCosts& costs) {
+    meshLandmarks(1, -1)->build(Game::collision_mesh_1, Game::collision_mesh_1_width, Game::collision_mesh_1_height, costs);
+    meshLandmarks(4, -1)->build(Game::collision_mesh_4, Game::collision_mesh_4_width, Game::collision_mesh_4_height, costs);
+    meshLandmarks(-1, 4)->build(Game::collision_mesh_macro_4, Game::collision_mesh_macro_4_width, Game::collision_mesh_macro_4_height, costs);
+}
+
+void clearMeshLandmarks() {
+    meshLandmarks(1, -1)->clear();
+    meshLandmarks(4, -1)->clear();
+    meshLandmarks(-1, 4)->clear();
 }
 
 
@@ -461,62 +702,60 @@ MeshNode findClosestWalkable(
 
 // receives a mesh of nodes to use as reference for path finding
 // will return a vector of points in which the FIRST(index:0) element is the DESTINATION with the following elements a path up until the start point
+// edges cost their length times the average multiplier of the two tiles, in `costs` of course
 std::vector<Vector2D> a_star_mesh(
     const MeshNode& start, const MeshNode& destination, 
     const std::vector<std::vector<uint8_t>>& mesh, const int branching_factor,
     const int mesh_width_limit, const int mesh_height_limit, const int density, const int macro_size,
-    const std::chrono::steady_clock::time_point& begin
+    const TerrainCosts& costs, const std::chrono::steady_clock::time_point& begin
 ) {
-    std::unordered_map<MeshNode, MeshNode, Node2Hash> parent;
-    std::unordered_map<MeshNode, float, Node2Hash> gscore;
-    std::unordered_map<MeshNode, float, Node2Hash> fscore;
-    parent[start] = start;
-    gscore[start] = 0.0f;
-    fscore[start] = heuristicCost(start, destination, mesh);
+    // same neighbors as getMeshNeighbors(), without building a vector for every node
+    const int neighbors = std::min(std::max(branching_factor, 4), 16);
 
-    std::unordered_set<MeshNode, Node2Hash> open_set;
-    NodeCompareByFScore cmp(fscore);
-    std::priority_queue<MeshNode, std::vector<MeshNode>, NodeCompareByFScore> open_queue(cmp);
-
-    open_queue.push(start);
-    open_set.insert(start);
+    const int width = mesh_width_limit + 1;
+    const int height = mesh_height_limit + 1;
+    MeshSearchScratch& scratch = meshSearchScratch();
+    scratch.begin(static_cast<size_t>(width) * height);
+    // only when it was measured on this very mesh, with the same costs and edges
+    const LandmarkTable* landmarks = meshLandmarks(density, macro_size);
+    if(landmarks && (branching_factor != 8 || !landmarks->builtFor(costs) || landmarks->width != width || landmarks->height != height)) {
+        landmarks = nullptr;
+    }
 
-    std::unordered_map<MeshNode, uint8_t, Node2Hash> closed;
+    const int start_index = (start.y * width) + start.x;
+    const int destination_index = (destination.y * width) + destination.x;
+    scratch.push(start_index, 0.0f, costs.weight * heuristicCost(start, destination, costs, branching_factor), start_index);
 
-    std::vector<MeshNode> curr_neighbors;
     MeshNode s, n;
-
-
-    int i, limit;
-    while(!open_queue.empty()) {
-        s = open_queue.top();
-        open_queue.pop();
-        open_set.erase(s);
+    while(!scratch.open.empty()) {
+        const MeshSearchScratch::OpenNode top = scratch.pop();
+        if(scratch.closed(top.index) || top.g > scratch.gscore[top.index]) { continue; } // already expanded with a better g
         
-        if(s == destination) {
+        if(top.index == destination_index) {
             std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
             std::cout << "a_star_mesh() Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
-            if(macro_size > 0) {
-                return reconstruct_path_macro_mesh(s, parent, macro_size);
-            }
-            return reconstruct_path_mesh(s, parent, density);
+            return reconstruct_path_mesh(top.index, scratch.parent, width, density, macro_size);
         }
 
-        closed[s] = 1;
-        curr_neighbors = getMeshNeighbors(s.x, s.y, mesh_width_limit, mesh_height_limit, branching_factor);
-        limit = curr_neighbors.size();
-        for(i=0; i<limit; ++i) {
-            n = curr_neighbors[i];
-            if(walkableInMesh(n.x, n.y, mesh)) {
-                if(meshDiagonalOK(s, n, mesh)) {
-                    if(closed.find(n) == closed.end()) {
-                        if(open_set.find(n) == open_set.end()) {
-                            gscore[n] = std::numeric_limits<float>::infinity();
-                        }
-                        update_vertex_mesh(s, n, parent, gscore, fscore, open_queue, open_set, destination, mesh);
-                    }
-                }                
+        scratch.close(top.index);
+        s = { top.index % width, top.index / width };
+        float s_multiplier = costs.multiplier[mesh[s.y][s.x]];
+        if(!costs.walkable(mesh[s.y][s.x])) { s_multiplier = costs.cheapest; } // a start pushed onto something blocked
+        for(int i=0; i<neighbors; ++i) {
+            n = { s.x + MESH_OFFSETS_X[i], s.y + MESH_OFFSETS_Y[i] };
+            if(n.x < 0 || n.y < 0 || n.x >= width || n.y >= height) { continue; }
+            const int n_index = (n.y * width) + n.x;
+            if(scratch.closed(n_index)) { continue; }
+            if(!walkableInMesh(n.x, n.y, mesh, costs) || !meshDiagonalOK(s, n, mesh, costs)) { continue; }
+
+            const float g = top.g + (meshOffsetLength(i) * 0.5f * (s_multiplier + costs.multiplier[mesh[n.y][n.x]]));
+            if(scratch.seen(n_index) && g >= scratch.gscore[n_index]) { continue; }
+            float h = heuristicCost(n, destination, costs, branching_factor);
+            if(landmarks) {
+                h = std::max(h, landmarks->lowerBound(n_index, destination_index));
+                if(h == std::numeric_limits<float>::infinity()) { continue; } // can't get to the destination from there
             }
+            scratch.push(n_index, g, g + (costs.weight * h), top.index);
         }
     }
 
@@ -525,7 +764,159 @@ std::vector<Vector2D> a_star_mesh(
     return {};
 }
 
-std::vector<Vector2D> find_path(const Vector2D& start, const Vector2D& destination, float& offcourse_limit) {
+// Jump Point Search (Harabor & Grastien): A* for meshes where every walkable node costs the same, so the terrain costs
+// are ignored and only what's walkable in `costs` matters. Straight and diagonal runs are walked without pushing anything
+// until they reach a node that can't be skipped (the destination, or one with a neighbor that can only be reached
+// optimally through it), which prunes all the paths that are the same length with the moves in another order. Open
+// terrain goes from every node being opened to a handful.
+// Diagonals follow meshDiagonalOK(): allowed as long as one of the two sides is walkable.
+class MeshJumpPoints {
+private:
+const std::vector<std::vector<uint8_t>>& mesh;
+const TerrainCosts& costs;
+const int width;
+const int height;
+const int destination_x;
+const int destination_y;
+
+bool open(int x, int y) const {
+    return x >= 0 && y >= 0 && x < this->width && y < this->height && this->costs.walkable(this->mesh[y][x]);
+}
+
+public:
+MeshJumpPoints(const std::vector<std::vector<uint8_t>>& m, const TerrainCosts& c, int w, int h, const MeshNode& destination)
+    : mesh(m), costs(c), width(w), height(h), destination_x(destination.x), destination_y(destination.y) {}
+
+// walks from {x, y} towards {dx, dy} and returns the index of the first node that has to be expanded, -1 if it ran into
+// something blocked first
+int jump(int x, int y, const int dx, const int dy) const {
+    while(true) {
+        if(dx != 0 && dy != 0 && !open(x + dx, y) && !open(x, y + dy)) { return -1; } // squeezing between two corners
+        x += dx; y += dy;
+        if(!open(x, y)) { return -1; }
+        const int index = (y * this->width) + x;
+        if(x == this->destination_x && y == this->destination_y) { return index; }
+
+        if(dx != 0 && dy != 0) {
+            if((open(x - dx, y + dy) && !open(x - dx, y)) || (open(x + dx, y - dy) && !open(x, y - dy))) { return index; }
+            // a diagonal stops wherever one of its straight runs finds something
+            if(jump(x, y, dx, 0) >= 0 || jump(x, y, 0, dy) >= 0) { return index; }
+        } else if(dx != 0) {
+            if((open(x + dx, y + 1) && !open(x, y + 1)) || (open(x + dx, y - 1) && !open(x, y - 1))) { return index; }
+        } else {
+            if((open(x + 1, y + dy) && !open(x + 1, y)) || (open(x - 1, y + dy) && !open(x - 1, y))) { return index; }
+        }
+    }
+}
+
+// directions worth jumping to from `s` when it was reached moving towards {dx, dy} ({0, 0} for the start).
+// returns how many were written to out_dx/out_dy
+int directions(const MeshNode& s, const int dx, const int dy, int out_dx[8], int out_dy[8]) const {
+    int count = 0;
+    auto add = [&](int x, int y) { out_dx[count] = x; out_dy[count] = y; ++count; };
+    if(dx == 0 && dy == 0) { // every direction from the start
+        for(int i=0; i<8; ++i) { add(MESH_OFFSETS_X[i], MESH_OFFSETS_Y[i]); }
+        return count;
+    }
+    const int x = s.x, y = s.y;
+    if(dx != 0 && dy != 0) {
+        const bool side_x = open(x + dx, y);
+        const bool side_y = open(x, y + dy);
+        if(side_y) { add(0, dy); }
+        if(side_x) { add(dx, 0); }
+        if(side_x || side_y) { add(dx, dy); }
+        // forced, around a corner behind
+        if(!open(x - dx, y) && side_y) { add(-dx, dy); }
+        if(!open(x, y - dy) && side_x) { add(dx, -dy); }
+    } else if(dx != 0) {
+        if(open(x + dx, y)) {
+            add(dx, 0);
+            if(!open(x, y + 1)) { add(dx, 1); }
+            if(!open(x, y - 1)) { add(dx, -1); }
+        }
+    } else {
+        if(open(x, y + dy)) {
+            add(0, dy);
+            if(!open(x + 1, y)) { add(1, dy); }
+            if(!open(x - 1, y)) { add(-1, dy); }
+        }
+    }
+    return count;
+}
+};
+
+// jump points are only linked by straight or diagonal runs, this fills in every node of those runs so the path looks
+// the same as one out of a_star_mesh()
+std::vector<Vector2D> reconstruct_jump_path_mesh(int s, const std::vector<int>& parent, const int mesh_width, const int density, const int macro_size) {
+    std::vector<Vector2D> total_path;
+    MeshNode n = { s % mesh_width, s / mesh_width };
+    while(true) {
+        total_path.push_back(macro_size > 0 ? convertMacroMeshNodeToVector2D(n, macro_size) : convertMeshNodeToVector2D(n, density));
+        if(parent[s] == s) { break; }
+        const MeshNode p = { parent[s] % mesh_width, parent[s] / mesh_width };
+        const int dx = (p.x > n.x) - (p.x < n.x);
+        const int dy = (p.y > n.y) - (p.y < n.y);
+        n.x += dx; n.y += dy;
+        if(n == p) { s = parent[s]; }
+    }
+    return total_path;
+}
+
+// same as a_star_mesh() with 8 neighbors, through jump points and treating every walkable node as if it cost the same
+std::vector<Vector2D> jump_point_search_mesh(
+    const MeshNode& start, const MeshNode& destination, 
+    const std::vector<std::vector<uint8_t>>& mesh,
+    const int mesh_width_limit, const int mesh_height_limit, const int density, const int macro_size,
+    const TerrainCosts& costs, const std::chrono::steady_clock::time_point& begin
+) {
+    const int width = mesh_width_limit + 1;
+    const int height = mesh_height_limit + 1;
+    MeshSearchScratch& scratch = meshSearchScratch();
+    scratch.begin(static_cast<size_t>(width) * height);
+    const MeshJumpPoints jumps(mesh, costs, width, height, destination);
+
+    const int start_index = (start.y * width) + start.x;
+    const int destination_index = (destination.y * width) + destination.x;
+    scratch.push(start_index, 0.0f, octileDistance(start, destination), start_index);
+
+    int dx[8], dy[8];
+    MeshNode s, n;
+    while(!scratch.open.empty()) {
+        const MeshSearchScratch::OpenNode top = scratch.pop();
+        if(scratch.closed(top.index) || top.g > scratch.gscore[top.index]) { continue; }
+
+        if(top.index == destination_index) {
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::cout << "jump_point_search_mesh() Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+            return reconstruct_jump_path_mesh(top.index, scratch.parent, width, density, macro_size);
+        }
+
+        scratch.close(top.index);
+        s = { top.index % width, top.index / width };
+        const int from = scratch.parent[top.index];
+        const int from_x = from % width, from_y = from / width;
+        const int directions = jumps.directions(s, (s.x > from_x) - (s.x < from_x), (s.y > from_y) - (s.y < from_y), dx, dy);
+        for(int i=0; i<directions; ++i) {
+            const int n_index = jumps.jump(s.x, s.y, dx[i], dy[i]);
+            if(n_index < 0 || scratch.closed(n_index)) { continue; }
+            n = { n_index % width, n_index / width };
+            const float g = top.g + octileDistance(s, n); // a straight or diagonal run, so octile is exact
+            if(scratch.seen(n_index) && g >= scratch.gscore[n_index]) { continue; }
+            scratch.push(n_index, g, g + octileDistance(n, destination), top.index);
+        }
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "jump_point_search_mesh() NO PATH Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]" << std::endl;
+    return {};
+}
+
+// `costs`: what the drone's tech level makes of each tile type
+// `search`: JUMP_POINTS only looks at what's walkable in `costs`, for when how long the path takes doesn't matter as much
+std::vector<Vector2D> find_path(
+    const Vector2D& start, const Vector2D& destination, float& offcourse_limit,
+    const TerrainCosts& costs = TerrainCosts::forTechLevel(0), const PathSearch search = PathSearch::A_STAR
+) {
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
     // really, I'm just eyeballing these differences for now
     static const float             one_by_one =               8192.0f; //    1x1 tile area
@@ -577,17 +968,27 @@ std::vector<Vector2D> find_path(const Vector2D& start, const Vector2D& destinati
     }
     
     // clamp out of bounds
+    if(start_node.x > width_limit) { start_node.x = width_limit; }
+    else if(start_node.x < 0) { start_node.x = 0; }
+    if(start_node.y > height_limit) { start_node.y = height_limit; }
+    else if(start_node.y < 0) { start_node.y = 0; }
     if(dest_node.x > width_limit) { dest_node.x = width_limit; }
     else if(dest_node.x < 0) { dest_node.x = 0; }
     if(dest_node.y > height_limit) { dest_node.y = height_limit; }
     else if(dest_node.y < 0) { dest_node.y = 0; }
     
-    if(walkableInMesh(dest_node.x, dest_node.y, *mesh)) {
-        std::vector<Vector2D> path = a_star_mesh(
-            start_node, dest_node, 
-            *mesh, branching_factor, width_limit, height_limit, 
-            density, macro_size, begin
-        );
+    if(walkableInMesh(dest_node.x, dest_node.y, *mesh, costs)) {
+        std::vector<Vector2D> path = search == PathSearch::JUMP_POINTS ?
+            jump_point_search_mesh(
+                start_node, dest_node,
+                *mesh, width_limit, height_limit,
+                density, macro_size, costs, begin
+            ) :
+            a_star_mesh(
+                start_node, dest_node, 
+                *mesh, branching_factor, width_limit, height_limit, 
+                density, macro_size, costs, begin
+            );
 
         // I don't think I'll need the macro_size=16 case for now
         // also maybe instead of doing this, signal to the drone that distance tolerance should be way higher
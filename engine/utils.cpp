@@ -1,4 +1,14 @@
 #include "utils.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 /*
@@ -218,30 +228,89 @@ bool getBMPProperties(const std::string& path, uint32_t* bmp_width, uint32_t* bm
     return true;
 }
 
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(std::filesystem::u8path(path).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(view == NULL) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    this->file_handle = file;
+    this->mapping_handle = mapping;
+    this->bytes = static_cast<const uint8_t*>(view);
+    this->length = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) { return false; }
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive on its own
+    if(view == MAP_FAILED) { return false; }
+    this->bytes = static_cast<const uint8_t*>(view);
+    this->length = static_cast<size_t>(file_stat.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if(this->bytes == nullptr) { return; }
+#ifdef _WIN32
+    UnmapViewOfFile(this->bytes);
+    CloseHandle(static_cast<HANDLE>(this->mapping_handle));
+    CloseHandle(static_cast<HANDLE>(this->file_handle));
+    this->mapping_handle = nullptr;
+    this->file_handle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(this->bytes), this->length);
+#endif
+    this->bytes = nullptr;
+    this->length = 0;
+}
+
 /*
-Output writes to a SDL_Color matrix in RGB with alpha OPAQUE. Pixels are stored by "rows" so pixel at position (x,y) is stored in pixels[y][x] (reverse).
+Output writes to a flat SDL_Color grid in RGB with alpha OPAQUE, pixel at position (x,y) is pixels[y][x] (top row first).
 Output writes width and height of the original BMP image.
 Returns true on success, and false on failure.
-This function is very similar to Map::LoadMapFile(), but it's independent from the Map class and from the color values.
+The file is memory mapped and decoded in a single pass straight into `pixels`, there's no intermediate copy of the image.
+Map::classifyTiles() turns the result into tile types.
 */ 
-bool getBMPPixels(const std::string& path, std::vector<std::vector<SDL_Color>>& pixels, uint32_t* bmp_width, uint32_t* bmp_height) {
+bool getBMPPixels(const std::string& path, MapPixels& pixels, uint32_t* bmp_width, uint32_t* bmp_height) {
     // https://stackoverflow.com/questions/9296059/read-pixel-value-in-bmp-file
     static constexpr size_t HEADER_SIZE = 54;
+    static constexpr uint32_t MAX_SIDE = 4096; // way past any map, keeps a crafted header from asking for gigabytes
 
-    std::ifstream bmp_file(std::filesystem::u8path(path), std::ios::binary);
-    if(!bmp_file) {
+    MappedFile bmp_file;
+    if(!bmp_file.open(path)) {
         std::cout << "getBMPPixels() - Failed to open file: " << path << '\n';
         return false;
     }
+    if(bmp_file.size() < HEADER_SIZE) {
+        printf("Invalid BMP: file too small.\n");
+        return false;
+    }
 
-    std::vector<char> header(HEADER_SIZE);
-    bmp_file.read(header.data(), HEADER_SIZE);
-
+    const uint8_t* header = bmp_file.data();
     const size_t size32 = sizeof(uint32_t);
-
-    uint32_t fileSize, dataOffset;
-
-    memcpy(  &fileSize, &header[2], size32);
+    uint32_t dataOffset;
+    uint16_t depth;
     memcpy(&dataOffset, &header[10], size32);
     memcpy(  bmp_width, &header[18], size32);
     if(*bmp_width % 4 !=0) {
@@ -249,38 +318,36 @@ bool getBMPPixels(const std::string& path, std::vector<std::vector<SDL_Color>>&
         return false;
     }
     memcpy( bmp_height, &header[22], size32);
-    uint16_t depth;
     memcpy(     &depth, &header[28], sizeof(uint16_t));
+    if(depth != 24) {
+        printf("Invalid BMP: only 24 bit images are supported.\n");
+        return false;
+    }
 
-    uint64_t dataSize = ((*bmp_width * 3 + 3) & (~3))  *  *bmp_height;
-    std::vector<char> img(dataSize);
-    bmp_file.read(img.data(), img.size());
-    bmp_file.close();
-
-    pixels.resize(*bmp_height);
-
-    char temp;
-    int line_offset = 0;
-    int line_index = *bmp_width;
-    int current_line;
-    SDL_Color current_pixel = { 0x00, 0x00, 0x00, SDL_ALPHA_OPAQUE }; // just to set alpha to every pixel
-    int tile_type;
-    // reads "bottom" row first
-    for(size_t i = 0; i < dataSize; i += 3) {
-        // BMP goes BGR
-        current_pixel.r = img[i+2];
-        current_pixel.g = img[i+1];
-        current_pixel.b = img[i];
-
-        if(line_index == *bmp_width) {
-            ++line_offset;
-            current_line = *bmp_height - line_offset;
-            pixels[current_line].resize(*bmp_width);
-            line_index = 0;
-        }
+    if(*bmp_width == 0 || *bmp_height == 0 || *bmp_width > MAX_SIDE || *bmp_height > MAX_SIDE) {
+        printf("Invalid BMP: size must be between 1 and %u.\n", MAX_SIDE);
+        return false;
+    }
+    if(dataOffset < HEADER_SIZE || dataOffset > bmp_file.size()) {
+        printf("Invalid BMP: pixel data offset out of the file.\n");
+        return false;
+    }
 
-        pixels[current_line][line_index] = current_pixel;
-        ++line_index;
+    // rows are padded to 4 bytes, a width multiple of 4 never needs it. Divided instead of multiplied so nothing can wrap
+    const uint64_t row_size = static_cast<uint64_t>(*bmp_width) * 3;
+    if(row_size > (bmp_file.size() - dataOffset) / *bmp_height) {
+        printf("Invalid BMP: pixel data is cut short.\n");
+        return false;
+    }
+
+    pixels.resize(*bmp_width, *bmp_height);
+    // the file has the "bottom" row first, BGR
+    for(uint32_t y=0; y<*bmp_height; ++y) {
+        const uint8_t* src = bmp_file.data() + dataOffset + row_size * (*bmp_height - 1 - y);
+        SDL_Color* dst = pixels[y];
+        for(uint32_t x=0; x<*bmp_width; ++x, src += 3) {
+            dst[x] = { src[2], src[1], src[0], SDL_ALPHA_OPAQUE };
+        }
     }
     return true;
 }
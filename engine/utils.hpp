@@ -12,6 +12,32 @@
 #include <SDL2/SDL.h>
 #include "Colors.hpp"
 #include "TextFieldEditStyle.hpp"
+#include "FlatGrid.hpp"
+
+// every pixel of a map image, map_pixels[y][x] (top row first)
+using MapPixels = FlatGrid<SDL_Color>;
+
+// Read only view of a whole file mapped into memory, unmapped when it goes out of scope
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const uint8_t* data() const { return this->bytes; }
+    size_t size() const { return this->length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
 
 
 uint8_t readBit(uint8_t byte, uint8_t bit);
@@ -37,9 +63,13 @@ std::string trim_copy(std::string s);
 
 std::vector<std::string> getFileNamesInDirectory(const std::string& directory, const std::string& file_format="");
 bool getBMPProperties(const std::string& path, uint32_t* bmp_width, uint32_t* bmp_height);
-bool getBMPPixels(const std::string& path, std::vector<std::vector<SDL_Color>>& pixels, uint32_t* bmp_width, uint32_t* bmp_height);
+bool getBMPPixels(const std::string& path, MapPixels& pixels, uint32_t* bmp_width, uint32_t* bmp_height);
 
 bool isSameColor(const SDL_Color& x, const SDL_Color& y);
+// RGBA in a single integer, to compare or look up colors with one operation
+inline uint32_t packColor(const SDL_Color& c) {
+    return (static_cast<uint32_t>(c.r) << 24) | (static_cast<uint32_t>(c.g) << 16) | (static_cast<uint32_t>(c.b) << 8) | c.a;
+}
 
 SDL_Color convertMainColorToSDL(const MainColors& mc);
 MainColors convertSDLColorToMainColor(const SDL_Color& sc);
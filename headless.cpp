@@ -0,0 +1,129 @@
+// Runs a match without a window, renderer or audio and reports how long the simulation takes per tick.
+// Build with `make headless`, then: ./headless <map_name> [ticks] [drones_per_spawn] [seed] [tech_level]
+// e.g. ./headless test_map 3000 20, or ./headless test_map 3000 20 1 1 to let the drones path through water
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <SDL2/SDL.h>
+#include "engine/Game.hpp"
+#include "engine/utils.hpp"
+#include "engine/Colors.hpp"
+#include "engine/CompiledMap.hpp"
+#include "engine/MatchSimulation.hpp"
+
+const int HEADLESS_TICK_RATE = 30;
+const int HEADLESS_BROADCAST_RATE = 10;
+const int ORDERS_INTERVAL = 90; // ticks between each wave of random move orders
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cout << "usage: " << argv[0] << " <map_name> [ticks] [drones_per_spawn] [seed] [tech_level]\n";
+        return 1;
+    }
+    const std::string map_name = argv[1];
+    const int ticks_to_run     = argc > 2 ? std::max(1, std::stoi(argv[2])) : 3000;
+    const int drones_per_spawn = argc > 3 ? std::max(1, std::stoi(argv[3])) : 1;
+    const uint32_t seed        = argc > 4 ? static_cast<uint32_t>(std::stoul(argv[4])) : 1;
+    const int tech_level       = argc > 5 ? std::max(0, std::stoi(argv[5])) : 0;
+
+    std::mt19937 rng(seed);
+    Game::initHeadless(HEADLESS_TICK_RATE, HEADLESS_BROADCAST_RATE, &rng);
+
+    const std::string map_path = "assets/maps/"+map_name;
+    std::shared_ptr<MapPixels> map_pixels = std::make_shared<MapPixels>();
+    CompiledMap compiled_map;
+    if(!loadMapPixels(map_path, *map_pixels, compiled_map)) {
+        std::cout << "Failed to load " << map_path << '\n';
+        return 1;
+    }
+
+    std::vector<std::pair<int, int>> spawn_positions = MatchSimulation::assignSpawnColors(*map_pixels);
+    if(spawn_positions.empty()) {
+        std::cout << "Map " << map_name << " has no spawns\n";
+        return 1;
+    }
+
+    MatchSimulation simulation;
+    if(!simulation.load(map_pixels, spawn_positions, &compiled_map)) {
+        std::cout << "Map failed to load.\n";
+        return 1;
+    }
+    compiled_map.close(); // everything the match needed was copied out of it
+
+    // the extra drones go in a ring around each spawn's first drone
+    const float ring_step = Game::UNIT_SIZE * 1.5f;
+    for(const std::pair<int,int>& pos : spawn_positions) {
+        MainColors c = convertSDLColorToMainColor((*simulation.map_pixels_colors)[pos.first][pos.second]);
+        Vector2D spawn_world = simulation.map->getWorldPosFromTileCoord(pos.second, pos.first-1);
+        for(int i=1; i<drones_per_spawn; ++i) {
+            const int ring = 1 + (i / 8);
+            const int slot = i % 8;
+            Vector2D offset = Vector2D(
+                ((slot % 3) - 1) * ring * ring_step,
+                ((slot / 3) - 1) * ring * ring_step
+            );
+            createDrone(spawn_world.x + offset.x, spawn_world.y + offset.y, c);
+        }
+    }
+    Game::manager->refresh();
+    for(auto& dr : simulation.drones) { dr->getComponent<DroneComponent>().tech_level = tech_level; }
+    std::cout << "Headless match: " << map_name << " | " << simulation.drones.size() << " drones | tech level " << tech_level << " | " << ticks_to_run << " ticks @ " << Game::TICK_RATE << " Hz\n";
+
+    std::vector<int64_t> tick_times;
+    tick_times.reserve(ticks_to_run);
+    int64_t path_time = 0;
+    int path_requests = 0;
+
+    std::chrono::steady_clock::time_point run_begin = std::chrono::steady_clock::now();
+    for(int t=0; t<ticks_to_run; ++t) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+        if(t % ORDERS_INTERVAL == 0) {
+            std::chrono::steady_clock::time_point path_begin = std::chrono::steady_clock::now();
+            for(auto& dr : simulation.drones) {
+                if(randomInt(Game::RNG, 0, 3) != 0) { continue; }
+                Vector2D destination = Vector2D(
+                    randomInt(Game::RNG, 0, static_cast<int>(Game::world_map_layout_width)-1),
+                    randomInt(Game::RNG, 0, static_cast<int>(Game::world_map_layout_height)-1)
+                );
+                dr->getComponent<DroneComponent>().moveToPoint(destination);
+                ++path_requests;
+            }
+            path_time += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - path_begin).count();
+        }
+
+        simulation.step();
+        ++Game::TICK_COUNT;
+
+        tick_times.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+    const int64_t run_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - run_begin).count();
+
+    int64_t total = 0;
+    for(const int64_t& tt : tick_times) { total += tt; }
+    std::vector<int64_t> sorted_times = tick_times;
+    std::sort(sorted_times.begin(), sorted_times.end());
+    const size_t n = sorted_times.size();
+
+    std::cout << "---------------- headless results ----------------\n";
+    std::cout << "ticks: " << n << " | wall time: " << run_time << "[us] | " << (n * 1000000.0 / std::max<int64_t>(run_time, 1)) << " ticks/s\n";
+    std::cout << "tick avg: " << (total / static_cast<int64_t>(n)) << "[us]"
+              << " min: " << sorted_times.front() << "[us]"
+              << " p50: " << sorted_times[n/2] << "[us]"
+              << " p99: " << sorted_times[std::min(n-1, (n*99)/100)] << "[us]"
+              << " max: " << sorted_times.back() << "[us]\n";
+    std::cout << "tick budget: " << static_cast<int64_t>(Game::TICK_DELTA * 1000000) << "[us]\n";
+    std::cout << "path requests: " << path_requests << " | total: " << path_time << "[us]";
+    if(path_requests > 0) { std::cout << " | avg: " << (path_time / path_requests) << "[us]"; }
+    std::cout << '\n';
+
+    simulation.clean();
+    Game::manager->clearEntities();
+    delete Game::manager;
+    Game::manager = nullptr;
+    return 0;
+}
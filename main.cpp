@@ -73,6 +73,11 @@ bool isValidConfigJson(const json& json_data, std::vector<std::string>& error_me
         valid = false;
     }
 
+    if(json_data.contains("LOCKSTEP") && !json_data["LOCKSTEP"].is_boolean()) {
+        error_messages.push_back("LOCKSTEP must be true or false (without quotation marks).");
+        valid = false;
+    }
+
     return valid;
 }
 
@@ -99,6 +104,7 @@ int main() {
             {"SCREEN_HEIGHT", 720},
             {"FULLSCREEN", false},
             {"FRAME_RATE", 60},
+            {"LOCKSTEP", false},
             {"USERS_IP", users_ip_data }
         };
         std::ofstream o("config.json");
@@ -129,6 +135,8 @@ int main() {
     uint64_t elapsed_time;
     uint64_t old_elapsed_time = 0;
     uint64_t frame = 0;
+    float tick_accumulator = 0.0f;
+    int ticks_this_frame;
 
     std::random_device os_seed;
     uint32_t seed = os_seed();
@@ -136,11 +144,13 @@ int main() {
 
     std::map<std::string, std::string> users_ip = config_data["USERS_IP"].get< std::map<std::string, std::string> >();
 
+    Game::LOCKSTEP = config_data.value("LOCKSTEP", false); // optional, older config files don't have it
     game = new Game();
     game->init(
         "Bétula Engine", 
         config_data["SCREEN_WIDTH"], config_data["SCREEN_HEIGHT"], config_data["FULLSCREEN"], 
         config_data["FRAME_RATE"], 
+        30,
         20,
         users_ip,
         &generator
@@ -168,7 +178,19 @@ int main() {
         game->handleEvents();
         if(!game->running()) { break; }
 
-        game->update();
+        // the simulation only ever moves in steps of TICK_DELTA, however long the frame took
+        tick_accumulator += game->FRAME_DELTA;
+        ticks_this_frame = 0;
+        while(tick_accumulator >= game->TICK_DELTA && ticks_this_frame < game->MAX_TICKS_PER_FRAME) {
+            game->update();
+            ++game->TICK_COUNT;
+            tick_accumulator -= game->TICK_DELTA;
+            ++ticks_this_frame;
+        }
+        // too far behind (window dragged, breakpoint, potato PC...), drop the backlog instead of trying to catch up forever
+        if(tick_accumulator >= game->TICK_DELTA) { tick_accumulator = 0.0f; }
+        game->TICK_ALPHA = tick_accumulator / game->TICK_DELTA;
+
         game->render();
 
         ++frame;
@@ -0,0 +1,77 @@
+// Map compiler: turns assets/maps/<map_name>.bmp into assets/maps/<map_name>.map with the layout, spawn table and every
+// collision mesh already built, so a match start only has to map it. Run it again whenever a BMP changes (the game falls
+// back to the BMP on its own when the compiled file is stale).
+// Build with `make mapc`, then: ./mapc <map_name> [map_name ...]
+// e.g. ./mapc map-0 map-1 map-2 map-3
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <SDL2/SDL.h>
+#include "engine/Game.hpp"
+#include "engine/utils.hpp"
+#include "engine/Map.hpp"
+#include "engine/CompiledMap.hpp"
+#include "engine/MatchSimulation.hpp"
+
+const std::string MAPS_DIR = "assets/maps/";
+
+bool compileMap(const std::string& map_name) {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const std::string map_path = MAPS_DIR+map_name;
+    const uint64_t source_hash = CompiledMap::hashFile(map_path+".bmp");
+
+    std::shared_ptr<MapPixels> source_pixels = std::make_shared<MapPixels>();
+    uint32_t map_width, map_height;
+    if(source_hash == 0 || !getBMPPixels(map_path+".bmp", *source_pixels, &map_width, &map_height)) {
+        std::cout << "Failed to load " << map_path << ".bmp\n";
+        return false;
+    }
+
+    // the meshes are built for a match with a player on every spawn, same as the dedicated server plays it
+    std::shared_ptr<MapPixels> played_pixels = std::make_shared<MapPixels>(*source_pixels);
+    std::vector<std::pair<int, int>> spawn_positions = MatchSimulation::assignSpawnColors(*played_pixels);
+    // LoadMapRender() turns the spawns into TILE_PLAIN as it goes, so keep the layout from before that
+    Map played_layout(played_pixels, nullptr, nullptr, nullptr, nullptr, nullptr, Game::DOUBLE_UNIT_SIZE);
+
+    MatchSimulation simulation;
+    bool compiled = simulation.load(played_pixels, spawn_positions)
+        && CompiledMap::write(map_path, source_hash, *source_pixels, played_layout.layout, spawn_positions);
+    simulation.clean();
+    Game::manager->clearEntities();
+    Game::manager->refresh();
+    if(!compiled) {
+        std::cout << "Failed to compile " << map_name << '\n';
+        return false;
+    }
+
+    // read it back the way the game will
+    CompiledMap check;
+    if(!check.open(map_path) || !check.matchesLayout(played_layout.layout) || check.spawns() != spawn_positions) {
+        std::cout << "Compiled " << map_path << ".map doesn't read back the same\n";
+        return false;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << map_path << ".map: " << check.width() << 'x' << check.height() << " | " << spawn_positions.size() << " spawns | "
+              << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[us]\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        std::cout << "usage: " << argv[0] << " <map_name> [map_name ...]\n";
+        return 1;
+    }
+    std::mt19937 rng(1);
+    Game::initHeadless(30, 10, &rng);
+
+    int failed = 0;
+    for(int i=1; i<argc; ++i) {
+        if(!compileMap(argv[i])) { ++failed; }
+    }
+    delete Game::manager;
+    Game::manager = nullptr;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// Dedicated authoritative server: runs the match simulation on a fixed tick without any window and serves the clients.
+// Build with `make server`, then: ./server <map_name> [port 1-65535] [tick_rate] [broadcast_rate] [lockstep]
+// e.g. ./server map-0 50000 30 10
+//      ./server map-0 50000 30 10 lockstep   (only the orders are sent, every client simulates the match itself)
+
+#include <chrono>
+#include <thread>
+#include <csignal>
+#include <random>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <SDL2/SDL.h>
+#include "engine/Game.hpp"
+#include "engine/utils.hpp"
+#include "engine/CompiledMap.hpp"
+#include "engine/MatchSimulation.hpp"
+#include "engine/networking/Server.hpp"
+
+// the only thing a signal handler may safely touch, the tick loop turns it into Game::isRunning
+static volatile std::sig_atomic_t stop_requested = 0;
+
+void onInterrupt(int) {
+    stop_requested = 1;
+}
+
+// the whole argument has to be a number in [min, max], `fallback` if it wasn't given at all
+bool parseArgument(int argc, char* argv[], int index, int min, int max, int fallback, int& out) {
+    if(argc <= index) {
+        out = fallback;
+        return true;
+    }
+    const char* begin = argv[index];
+    const char* end = begin + std::char_traits<char>::length(begin);
+    auto [last, ec] = std::from_chars(begin, end, out);
+    return ec == std::errc() && last == end && out >= min && out <= max;
+}
+
+int main(int argc, char* argv[]) {
+    const std::string usage = std::string("usage: ") + argv[0] + " <map_name> [port 1-65535] [tick_rate] [broadcast_rate] [lockstep]\n";
+    if(argc < 2) {
+        std::cout << usage;
+        return 1;
+    }
+    const std::string map_name = argv[1];
+    int port, tick_rate, broadcast_rate;
+    if(!parseArgument(argc, argv, 2, 1, 65535, 50000, port)
+        || !parseArgument(argc, argv, 3, 1, INT_MAX, 30, tick_rate)
+        || !parseArgument(argc, argv, 4, 1, INT_MAX, 10, broadcast_rate)) {
+        std::cout << usage;
+        return 1;
+    }
+    broadcast_rate = std::min(broadcast_rate, tick_rate);
+    const bool lockstep = argc > 5 && std::string(argv[5]) == "lockstep";
+
+    std::random_device rd;
+    std::mt19937 rng(rd());
+    Game::initHeadless(tick_rate, broadcast_rate, &rng);
+
+    const std::string map_path = "assets/maps/"+map_name;
+    std::shared_ptr<MapPixels> map_pixels = std::make_shared<MapPixels>();
+    CompiledMap compiled_map;
+    if(!loadMapPixels(map_path, *map_pixels, compiled_map)) {
+        std::cout << "Failed to load " << map_path << '\n';
+        return 1;
+    }
+    std::vector<std::pair<int, int>> spawn_positions = MatchSimulation::assignSpawnColors(*map_pixels);
+    if(spawn_positions.empty()) {
+        std::cout << "Map " << map_name << " has no spawns\n";
+        return 1;
+    }
+
+    MatchSimulation simulation;
+    if(!simulation.load(map_pixels, spawn_positions, &compiled_map)) {
+        std::cout << "Map failed to load.\n";
+        return 1;
+    }
+    compiled_map.close(); // everything the match needed was copied out of it
+
+    // no host player, every spawn is up for grabs
+    Server* server = new Server(*map_pixels, { -1, -1 }, spawn_positions, map_name, static_cast<uint16_t>(port), "dedicated");
+    if(lockstep) {
+        server->EnableLockstep();
+        simulation.lockstep.enabled = true;
+    }
+    if(!server->Start()) {
+        delete server;
+        return 1;
+    }
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+    std::cout << "Serving " << map_name << " on port " << port << " | " << spawn_positions.size() << " spawns | " << Game::TICK_RATE << " Hz" << (lockstep ? " | lockstep" : "") << '\n';
+
+    const std::chrono::microseconds tick_duration(1000000 / Game::TICK_RATE);
+    std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now();
+    while(Game::isRunning) {
+        if(stop_requested) {
+            Game::isRunning = false;
+            break;
+        }
+        // handle everything the clients sent since the last tick, then advance the world
+        server->Update(-1);
+        if(lockstep) {
+            server->SealTurn(simulation.tick, simulation.lockstep);
+        } else {
+            server->ApplySolvedPaths(static_cast<uint32_t>(simulation.tick)); // whatever the path workers finished since the last tick
+        }
+        simulation.step();
+
+        if(Game::TICK_COUNT % Game::CLIENT_PING_RATE == 0) { // once every 3 s
+            server->PingAllClients();
+        }
+        if(!lockstep && Game::TICK_COUNT % Game::SERVER_STATE_SHARE_RATE == 0) {
+            server->BroadcastDronesState(static_cast<uint32_t>(simulation.tick));
+        }
+        ++Game::TICK_COUNT;
+
+        next_tick += tick_duration;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now < next_tick) {
+            std::this_thread::sleep_until(next_tick);
+        } else if(now - next_tick > tick_duration * Game::MAX_TICKS_PER_FRAME) {
+            // way behind (e.g. stalled on a big path request), don't try to catch up on all of it
+            std::cout << "WARNING: server is " << std::chrono::duration_cast<std::chrono::milliseconds>(now - next_tick).count() << "[ms] behind, skipping ticks\n";
+            next_tick = now;
+        }
+    }
+
+    std::cout << "Stopping server\n";
+    delete server; // stops it
+    simulation.clean();
+    Game::manager->clearEntities();
+    delete Game::manager;
+    Game::manager = nullptr;
+    return 0;
+}